@@ -14,6 +14,23 @@ VertexOutput vertex vertexMainGeneral(VertexInput input [[stage_in]]) {
     payload.color = half3(input.color);
     return payload;
 }
+// PackedVertex: position quantized across the mesh bounds, color index into the palette
+struct PackedVertexInput {
+    float2 position [[attribute(0)]];   // ushort2 normalized, [0, 1]
+    ushort color [[attribute(1)]];
+};
+struct PackedMeshUniforms {
+    float2 origin;
+    float2 scale;
+};
+VertexOutput vertex vertexMainPacked(PackedVertexInput input [[stage_in]],
+                                     constant PackedMeshUniforms& mesh [[buffer(1)]],
+                                     constant float4* palette [[buffer(2)]]) {
+    VertexOutput payload;
+    payload.position = float4(mesh.origin + input.position * mesh.scale, 0.0, 1.0);
+    payload.color = half3(palette[input.color].rgb);
+    return payload;
+}
 half4 fragment fragmentMainGeneral(VertexOutput frag [[stage_in]]) {
     return half4(frag.color, 1.0);
 }
@@ -0,0 +1,819 @@
+// Headless micro-benchmarks, not part of the app target. Build from hello_metal_cpp/src:
+//   c++ -std=c++20 -O2 -march=native -I external bench/bench.cpp geometry/*.cpp -o bench
+// and run `./bench` for every case or `./bench <name>...` for a subset.
+#include "../geometry/band_field.h"
+#include "../geometry/bezier.h"
+#include "../geometry/closest_point.h"
+#include "../geometry/forward_difference.h"
+#include "../geometry/offset_curve.h"
+#include "../geometry/parallel.h"
+#include "../geometry/simd_float.h"
+#include "../geometry/voronoi_grid.h"
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#include "../geometry/svg_segments.h"
+#include "../geometry/curve_cache.h"
+#include "../geometry/fill.h"
+#include "../geometry/packed_vertex.h"
+#include "../geometry/stroke.h"
+#include "../geometry/svg_mesh.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Every operator new of the process is counted, for the allocation benchmarks
+static std::atomic<size_t> allocationCount = 0;
+static std::atomic<size_t> allocationBytes = 0;
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC pairs free() with the operator new at each inlined call site and warns about a
+// mismatch; here the replaced operator new above is malloc, so the pair does match.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<CubicSegment> randomSegments(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+    std::vector<CubicSegment> segments(count);
+    for (CubicSegment& c : segments) {
+        c = { { coord(rng), coord(rng) }, { coord(rng), coord(rng) }, { coord(rng), coord(rng) }, { coord(rng), coord(rng) } };
+    }
+    return segments;
+}
+
+// Direct Bernstein evaluation vs. the forward-difference stepper at 100/500/1000 samples.
+// Each segment is written into the same cache-resident buffer so the timing measures the
+// evaluation, not page faults of a huge output array.
+static void benchForwardDifference() {
+    std::vector<CubicSegment> segments = randomSegments(20000);
+    for (int numLines : { 100, 500, 1000 }) {
+        std::vector<Point2> direct(numLines + 1), stepped(numLines + 1);
+        float checksum = 0.0f;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const CubicSegment& c : segments) {
+            for (int i = 0; i <= numLines; i++) {
+                direct[i] = Bezier::evaluate(c, 1.0f * i / numLines);
+            }
+            checksum += direct[numLines / 2].x;
+        }
+        double directMs = elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const CubicSegment& c : segments) {
+            ForwardDifferenceStepper stepper(c, numLines);
+            stepper.fill(stepped.data());
+            checksum -= stepped[numLines / 2].x;
+        }
+        double steppedMs = elapsedMs(start);
+
+        float maxError = 0.0f;
+        for (const CubicSegment& c : segments) {
+            ForwardDifferenceStepper stepper(c, numLines);
+            stepper.fill(stepped.data());
+            for (int i = 0; i <= numLines; i++) {
+                Point2 exact = Bezier::evaluate(c, 1.0f * i / numLines);
+                Point2 p = stepped[i];
+                maxError = std::max(maxError, std::max(std::fabs(p.x - exact.x), std::fabs(p.y - exact.y)));
+            }
+        }
+        printf("forward_difference n=%-5d direct %8.2f ms  stepped %8.2f ms  speedup %.2fx  max error %.2g  (checksum %g)\n",
+               numLines, directMs, steppedMs, directMs / steppedMs, maxError, checksum);
+    }
+}
+
+// Normals, curvature and offset points of 100k segments at 2/16/64 parameters: one
+// Bezier::derivative + sqrt per sample vs. the batch kernel vectorized across segments.
+static void benchCurveFrames() {
+    std::vector<CubicSegment> segments = randomSegments(100000);
+    CubicSegmentsSoA soa;
+    soa.reserve(segments.size());
+    for (const CubicSegment& c : segments) {
+        soa.push(c);
+    }
+    const float offset = 0.1f;
+    for (int samples : { 2, 16, 64 }) {
+        BezierBasis basis = BezierBasis::uniform(samples);
+        std::vector<float> offsetX(segments.size() * samples), offsetY(segments.size() * samples);
+        std::vector<float> curvature(segments.size() * samples);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t s = 0; s < segments.size(); s++) {
+            const CubicSegment& c = segments[s];
+            for (int k = 0; k < samples; k++) {
+                float t = samples > 1 ? 1.0f * k / (samples - 1) : 0.0f;
+                Point2 p = Bezier::evaluate(c, t);
+                Point2 d = Bezier::derivative(c, t);
+                Point2 dd = Bezier::secondDerivative(c, t);
+                float speed = std::sqrt(d.x * d.x + d.y * d.y);
+                size_t i = (size_t)k * segments.size() + s;
+                offsetX[i] = p.x - offset * d.y / speed;
+                offsetY[i] = p.y + offset * d.x / speed;
+                curvature[i] = (d.x * dd.y - d.y * dd.x) / (speed * speed * speed);
+            }
+        }
+        double scalarMs = elapsedMs(start);
+
+        CurveFrames frames;
+        Bezier::evaluateFrames(soa, basis, offset, frames);  // warm the output arrays
+        start = std::chrono::steady_clock::now();
+        Bezier::evaluateFrames(soa, basis, offset, frames);
+        double batchMs = elapsedMs(start);
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < offsetX.size(); i++) {
+            maxError = std::max(maxError, std::max(std::fabs(offsetX[i] - frames.offsetX[i]), std::fabs(offsetY[i] - frames.offsetY[i])));
+        }
+        printf("curve_frames n=%-3d scalar %8.2f ms  batch (%s) %8.2f ms  speedup %.2fx  max offset error %.2g\n",
+               samples, scalarMs, Bezier::batchBackend(), batchMs, scalarMs / batchMs, maxError);
+    }
+}
+
+// Offsets of 20k segments as cubics at two tolerances vs. the 64 sampled points per segment
+// of Bezier::evaluateFrames: pieces, bytes and time, and the worst miss of the cubics from
+// those samples, measured on flattened pieces of the first 500 segments.
+static void benchOffsetCurve() {
+    std::vector<CubicSegment> segments = randomSegments(20000);
+    CubicSegmentsSoA soa;
+    soa.reserve(segments.size());
+    for (const CubicSegment& c : segments) {
+        soa.push(c);
+    }
+    const float offset = 0.05f;
+    const int samples = 64;
+    CurveFrames frames;
+    auto start = std::chrono::steady_clock::now();
+    Bezier::evaluateFrames(soa, BezierBasis::uniform(samples), offset, frames);
+    double framesMs = elapsedMs(start);
+    printf("offset_curve sampled n=%d  %8.2f ms  %9zu bytes\n", samples, framesMs, segments.size() * samples * sizeof(Point2));
+
+    const size_t checked = 500;
+    for (float tolerance : { 1e-3f, 1e-4f }) {
+        OffsetCurveOptions options;
+        options.tolerance = tolerance;
+        start = std::chrono::steady_clock::now();
+        OffsetCurves curves = Bezier::offsetCurves(soa, offset, options);
+        double ms = elapsedMs(start);
+
+        float maxError = 0.0f;
+        std::vector<Point2> flat;
+        for (size_t s = 0; s < checked; s++) {
+            flat.clear();
+            for (uint32_t k = curves.firstPiece[s]; k < curves.firstPiece[s + 1]; k++) {
+                for (int j = 0; j <= 256; j++) {
+                    flat.push_back(Bezier::evaluate(curves.cubics[k], j / 256.0f));
+                }
+            }
+            for (int k = 1; k < samples - 1; k++) {
+                size_t i = frames.index(s, k);
+                Point2 p = { frames.offsetX[i], frames.offsetY[i] };
+                float best = INFINITY;
+                for (size_t j = 1; j < flat.size(); j++) {
+                    Point2 a = flat[j - 1], b = flat[j];
+                    float dx = b.x - a.x, dy = b.y - a.y, lengthSq = dx * dx + dy * dy;
+                    float u = lengthSq > 0.0f ? std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSq, 0.0f, 1.0f) : 0.0f;
+                    best = std::min(best, std::hypot(a.x + u * dx - p.x, a.y + u * dy - p.y));
+                }
+                maxError = std::max(maxError, best);
+            }
+        }
+        printf("offset_curve tol=%-6g %8.2f ms  %9zu bytes  %.2f cubics/segment  max error %.2g\n", tolerance, ms,
+               curves.cubics.size() * sizeof(CubicSegment), (double)curves.cubics.size() / segments.size(), maxError);
+    }
+}
+
+// Batched closest-point queries vs. one SegmentBvh::nearest call per query, on many short
+// segments like the ones a tessellated SVG produces.
+static void benchClosestPoint() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-1.0f, 1.0f), offset(-0.003f, 0.003f);
+    CubicSegmentsSoA segments;
+    for (int i = 0; i < 100000; i++) {
+        Point2 p = { coord(rng), coord(rng) };
+        segments.push({ p, { p.x + offset(rng), p.y + offset(rng) }, { p.x + offset(rng), p.y + offset(rng) },
+                        { p.x + offset(rng), p.y + offset(rng) } });
+    }
+    std::vector<float> qx(1000000), qy(1000000);
+    for (size_t i = 0; i < qx.size(); i++) {
+        qx[i] = coord(rng);
+        qy[i] = coord(rng);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ClosestPointEngine engine(segments);
+    double buildMs = elapsedMs(start);
+
+    ClosestPointResults results;
+    start = std::chrono::steady_clock::now();
+    engine.query(qx, qy, results);
+    double batchMs = elapsedMs(start);
+
+    float maxError = 0.0f;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < qx.size(); i++) {
+        SegmentBvh::NearestHit hit = engine.getBvh().nearest({ qx[i], qy[i] });
+        maxError = std::max(maxError, results.distance[i] - std::sqrt(hit.point.distanceSq));
+    }
+    double singleMs = elapsedMs(start);
+    printf("closest_point %zu queries  build %.2f ms  batch %8.2f ms  single %8.2f ms  speedup %.2fx  max excess %.2g\n",
+           qx.size(), buildMs, batchMs, singleMs, singleMs / batchMs, maxError);
+}
+
+// Jump flooding and the exact distance transform over a few hundred curves at increasing
+// grid sizes (4096^2 is 16 megapixels).
+static void benchVoronoi() {
+    CubicSegmentsSoA segments;
+    for (const CubicSegment& c : randomSegments(300)) {
+        segments.push(c);
+    }
+    const std::pair<const char*, VoronoiGrid (*)(const CubicSegmentsSoA&, const VoronoiGridOptions&)> methods[] = {
+        { "jump_flood", Voronoi::jumpFlood },
+        { "distance_transform", Voronoi::distanceTransform },
+    };
+    for (int size : { 1024, 4096, 8192 }) {
+        for (const auto& [name, method] : methods) {
+            VoronoiGridOptions options;
+            options.width = size;
+            options.height = size;
+            auto start = std::chrono::steady_clock::now();
+            VoronoiGrid grid = method(segments, options);
+            double ms = elapsedMs(start);
+            printf("voronoi %-18s %5dx%-5d %9.2f ms  %7.1f Mcells/s  (%u threads, %s)\n", name, size, size, ms,
+                   grid.size() / ms / 1000.0, Parallel::threadCount(), SIMD_FLOAT_BACKEND);
+        }
+    }
+
+    // A domain away from every curve seeds nothing; both methods leave every cell unlabeled
+    VoronoiGridOptions away;
+    away.width = 256;
+    away.height = 256;
+    away.domain = { { 10.0f, 10.0f }, { 11.0f, 11.0f } };
+    for (const auto& [name, method] : methods) {
+        VoronoiGrid grid = method(segments, away);
+        size_t labeled = std::count_if(grid.segment.begin(), grid.segment.end(), [](uint32_t s) { return s != VoronoiGrid::kInvalid; });
+        size_t finite = std::count_if(grid.distance.begin(), grid.distance.end(), [](float d) { return std::isfinite(d); });
+        printf("voronoi %-18s empty domain  %zu labeled, %zu finite of %zu cells\n", name, labeled, finite, grid.size());
+    }
+}
+
+// Narrow band field at the default band width vs. the memory a dense grid of the same
+// resolution over [-1, 1]^2 would take, for short and long curves.
+static void benchBandField() {
+    for (float length : { 0.05f, 0.3f }) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> coord(-1.0f, 1.0f), offset(-length, length);
+        CubicSegmentsSoA segments;
+        for (int i = 0; i < 40; i++) {
+            Point2 p = { coord(rng), coord(rng) };
+            segments.push({ p, { p.x + offset(rng), p.y + offset(rng) }, { p.x + offset(rng), p.y + offset(rng) },
+                            { p.x + offset(rng), p.y + offset(rng) } });
+        }
+        BandFieldOptions options;
+        options.cellSize = 2.0f / 2048;
+        auto start = std::chrono::steady_clock::now();
+        BandDistanceField field(segments, options);
+        double ms = elapsedMs(start);
+        double denseBytes = 2048.0 * 2048.0 * (sizeof(float) + sizeof(uint32_t));
+        printf("band_field curve size %.2f  build %8.2f ms  %6zu tiles  %7.1f MB  (dense 2048^2: %.1f MB)\n", length, ms,
+               field.tileCount(), field.memoryBytes() / 1e6, denseBytes / 1e6);
+    }
+}
+
+// Writes an SVG of roughly `bytes` made of many small cubic paths, like the exports we load.
+static std::string writeLargeSvg(size_t bytes) {
+    std::string path = (std::filesystem::temp_directory_path() / "bench_large.svg").string();
+    FILE* fp = fopen(path.c_str(), "wb");
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coord(0.0f, 1000.0f);
+    size_t written = fprintf(fp, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\">\n");
+    while (written < bytes) {
+        written += fprintf(fp, "<path fill=\"none\" stroke=\"#000\" d=\"M%.3f %.3fC%.3f %.3f %.3f %.3f %.3f %.3fC%.3f %.3f %.3f %.3f %.3f %.3f\"/>\n",
+                           coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng),
+                           coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng));
+    }
+    fprintf(fp, "</svg>\n");
+    fclose(fp);
+    return path;
+}
+
+// The old load path: a malloc'd copy of the whole file, parsed in place
+static NSVGimage* loadWithRead(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    fseek(fp, 0, SEEK_END);
+    size_t size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    std::vector<char> data(size + 1);
+    size_t read = fread(data.data(), 1, size, fp);
+    fclose(fp);
+    return nsvgParseBuffer(data.data(), read, "px", 96);
+}
+
+// fread + copy vs. nsvgParseFromFile's private mapping on a large file. Each path runs in a
+// child process so its peak resident size can be reported on its own.
+static void benchSvgLoad() {
+    std::string path = writeLargeSvg(256u << 20);
+    const std::pair<const char*, NSVGimage* (*)(const char*)> loaders[] = {
+        { "read", loadWithRead },
+        { "mmap", [](const char* file) { return nsvgParseFromFile(file, "px", 96); } },
+    };
+    for (const auto& [name, load] : loaders) {
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            auto start = std::chrono::steady_clock::now();
+            NSVGimage* image = load(path.c_str());
+            double ms = elapsedMs(start);
+            int shapes = 0;
+            for (NSVGshape* shape = image ? image->shapes : nullptr; shape != nullptr; shape = shape->next) {
+                shapes++;
+            }
+            printf("svg_load %-4s %8.2f ms  %7.1f MB/s  %d shapes\n", name, ms,
+                   std::filesystem::file_size(path) / 1e6 / (ms / 1000.0), shapes);
+            nsvgDelete(image);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        struct rusage usage;
+        wait4(child, &status, 0, &usage);
+#ifdef __APPLE__
+        double peakMB = usage.ru_maxrss / 1e6;  // bytes on macOS
+#else
+        double peakMB = usage.ru_maxrss / 1e3;  // kilobytes on Linux
+#endif
+        printf("svg_load %-4s peak resident %.1f MB\n", name, peakMB);
+    }
+    std::filesystem::remove(path);
+}
+
+// Path data throughput: the number tokenizer alone on a buffer of coordinates, then whole
+// in-memory documents through nsvgParse.
+static void benchSvgParse() {
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    std::string numbers;
+    while (numbers.size() < (64u << 20)) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.3f,", coord(rng));
+        numbers += buf;
+    }
+    auto start = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for (const char* s = numbers.c_str(); *s; s++) {
+        double value;
+        s = nsvg__parseNumberValue(s, &value);
+        sum += value;
+    }
+    double ms = elapsedMs(start);
+    printf("svg_parse numbers   %8.2f ms  %7.1f MB/s  (checksum %g)\n", ms, numbers.size() / 1e6 / (ms / 1000.0), sum);
+
+    std::string document = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\">";
+    while (document.size() < (64u << 20)) {
+        document += "<path d=\"M";
+        for (int i = 0; i < 32; i++) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.3f %.3f%s", coord(rng), coord(rng), i % 3 == 0 ? "C" : " ");
+            document += buf;
+        }
+        document += "0 0 0 0\"/>";
+    }
+    document += "</svg>";
+    std::vector<char> buffer(document.begin(), document.end());
+    buffer.push_back('\0');
+    start = std::chrono::steady_clock::now();
+    NSVGimage* image = nsvgParseBuffer(buffer.data(), document.size(), "px", 96);
+    ms = elapsedMs(start);
+    printf("svg_parse document  %8.2f ms  %7.1f MB/s\n", ms, document.size() / 1e6 / (ms / 1000.0));
+    nsvgDelete(image);
+}
+
+// Control points only: nsvgParse + SvgSegments::fromImage against the geometry-only
+// SvgSegments::parse, on a document of many small styled shapes in nested groups.
+static void benchSvgStream() {
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> coord(0.0f, 1000.0f);
+    std::string document = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\">"
+                           "<defs><linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"#f00\"/>"
+                           "<stop offset=\"1\" stop-color=\"#00f\"/></linearGradient></defs>";
+    while (document.size() < (64u << 20)) {
+        document += "<g transform=\"translate(1 2)\" fill=\"url(#g)\" stroke=\"#123456\" stroke-width=\"2\">";
+        for (int shape = 0; shape < 8; shape++) {
+            document += "<path d=\"";
+            for (int sub = 0; sub < 2; sub++) {
+                char buf[160];
+                snprintf(buf, sizeof(buf), "M%.2f %.2fC%.2f %.2f %.2f %.2f %.2f %.2fL%.2f %.2fZ", coord(rng), coord(rng), coord(rng),
+                         coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng));
+                document += buf;
+            }
+            document += "\"/>";
+        }
+        document += "</g>";
+    }
+    document += "</svg>";
+    std::vector<char> buffer(document.size() + 1);
+
+    memcpy(buffer.data(), document.c_str(), document.size() + 1);
+    auto start = std::chrono::steady_clock::now();
+    NSVGimage* image = nsvgParse(buffer.data(), "px", 96);
+    SvgSegments fromImage = SvgSegments::fromImage(image);
+    double ms = elapsedMs(start);
+    // One malloc per shape, two per path (struct + points), plus gradients
+    size_t shapes = 0, paths = 0;
+    for (NSVGshape* shape = image->shapes; shape != nullptr; shape = shape->next, shapes++) {
+        for (NSVGpath* path = shape->paths; path != nullptr; path = path->next) {
+            paths++;
+        }
+    }
+    nsvgDelete(image);
+    printf("svg_stream image     %8.2f ms  %7.1f MB/s  %zu segments, ~%zu parser mallocs\n", ms,
+           document.size() / 1e6 / (ms / 1000.0), fromImage.size(), shapes + 2 * paths);
+
+    memcpy(buffer.data(), document.c_str(), document.size() + 1);
+    start = std::chrono::steady_clock::now();
+    SvgSegments streamed = SvgSegments::parse(buffer.data());
+    ms = elapsedMs(start);
+    bool same = streamed.curves.x0 == fromImage.curves.x0 && streamed.curves.y3 == fromImage.curves.y3 &&
+                streamed.pathIds == fromImage.pathIds;
+    printf("svg_stream geometry  %8.2f ms  %7.1f MB/s  %zu segments, %s\n", ms,
+           document.size() / 1e6 / (ms / 1000.0), streamed.size(), same ? "identical" : "MISMATCH");
+}
+
+// NSVGimage lifetime on 100k styled paths: parse into the arena, walk every path's points,
+// release everything with nsvgDelete.
+static void benchSvgImage() {
+    std::mt19937 rng(14);
+    std::uniform_real_distribution<float> coord(0.0f, 1000.0f);
+    std::string document = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\">"
+                           "<defs><linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"#f00\"/></linearGradient></defs>";
+    for (int i = 0; i < 100000; i++) {
+        char buf[200];
+        snprintf(buf, sizeof(buf), "<path fill=\"%s\" d=\"M%.2f %.2fC%.2f %.2f %.2f %.2f %.2f %.2fZ\"/>", i % 4 ? "#123456" : "url(#g)",
+                 coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng), coord(rng));
+        document += buf;
+    }
+    document += "</svg>";
+
+    auto start = std::chrono::steady_clock::now();
+    NSVGimage* image = nsvgParse(document.data(), "px", 96);
+    double parseMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    SvgSegments segments = SvgSegments::fromImage(image);
+    double walkMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    nsvgDelete(image);
+    double deleteMs = elapsedMs(start);
+    printf("svg_image parse %8.2f ms  walk %6.2f ms  delete %6.2f ms  (%zu segments)\n", parseMs, walkMs, deleteMs, segments.size());
+}
+
+// Startup cost of a 64 MB drawing: parsing the XML vs. hashing the source and mapping its
+// curve cache, with and without copying the segments out of the mapping.
+static void benchSvgCache() {
+    std::string path = writeLargeSvg(64u << 20);
+    std::string cachePath = CurveCache::defaultPath(path.c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    SvgSegments parsed = SvgSegments::fromFile(path.c_str());
+    double parseMs = elapsedMs(start);
+    uint64_t hash = 0;
+    CurveCache::hashFile(path.c_str(), hash);
+    start = std::chrono::steady_clock::now();
+    CurveCache::write(cachePath.c_str(), hash, parsed);
+    double writeMs = elapsedMs(start);
+    printf("svg_cache parse     %8.2f ms  (%zu segments, cache written in %.2f ms, %.1f MB)\n", parseMs, parsed.size(),
+           writeMs, std::filesystem::file_size(cachePath) / 1e6);
+
+    start = std::chrono::steady_clock::now();
+    CurveCache::hashFile(path.c_str(), hash);
+    double hashMs = elapsedMs(start);
+    CurveCacheFile cache;
+    bool hit = cache.open(cachePath.c_str(), hash);
+    double mapMs = elapsedMs(start);
+    SvgSegments loaded = cache.toSegments();
+    double copyMs = elapsedMs(start);
+    bool same = loaded.curves.x0 == parsed.curves.x0 && loaded.curves.y3 == parsed.curves.y3 && loaded.pathIds == parsed.pathIds;
+    printf("svg_cache hash      %8.2f ms  %7.1f MB/s\n", hashMs, std::filesystem::file_size(path) / 1e6 / (hashMs / 1000.0));
+    printf("svg_cache map       %8.2f ms  (%s)\n", mapMs, hit ? "hit" : "MISS");
+    printf("svg_cache copy      %8.2f ms  (%s)\n", copyMs, same ? "identical" : "MISMATCH");
+    cache.close();
+    std::filesystem::remove(cachePath);
+    std::filesystem::remove(path);
+}
+
+// One 64 MB document: nsvgParse against nsvgParseParallel, once with the shape elements parsed
+// serially after the pre-scan (no executor) and once across Parallel::threadCount() threads.
+static void benchSvgParallel() {
+    std::string path = writeLargeSvg(64u << 20);
+    std::string document;
+    {
+        FILE* fp = fopen(path.c_str(), "rb");
+        document.resize(std::filesystem::file_size(path));
+        document.resize(fread(document.data(), 1, document.size(), fp));
+        fclose(fp);
+    }
+    std::filesystem::remove(path);
+    std::vector<char> buffer(document.size() + 1);
+
+    memcpy(buffer.data(), document.c_str(), document.size() + 1);
+    auto start = std::chrono::steady_clock::now();
+    NSVGimage* image = nsvgParse(buffer.data(), "px", 96);
+    SvgSegments serial = SvgSegments::fromImage(image);
+    double ms = elapsedMs(start);
+    nsvgDelete(image);
+    printf("svg_parallel serial       %8.2f ms  %7.1f MB/s  %zu segments\n", ms, document.size() / 1e6 / (ms / 1000.0),
+           serial.size());
+
+    memcpy(buffer.data(), document.c_str(), document.size() + 1);
+    start = std::chrono::steady_clock::now();
+    image = nsvgParseParallel(buffer.data(), "px", 96, nullptr, nullptr);
+    SvgSegments deferred = SvgSegments::fromImage(image);
+    ms = elapsedMs(start);
+    nsvgDelete(image);
+    printf("svg_parallel deferred     %8.2f ms  %7.1f MB/s  (pre-scan + 1 thread)\n", ms, document.size() / 1e6 / (ms / 1000.0));
+
+    memcpy(buffer.data(), document.c_str(), document.size() + 1);
+    start = std::chrono::steady_clock::now();
+    SvgSegments parallel = SvgSegments::parseParallel(buffer.data());
+    ms = elapsedMs(start);
+    bool same = parallel.curves.x0 == serial.curves.x0 && parallel.curves.y3 == serial.curves.y3 &&
+                parallel.shapeIds == serial.shapeIds && deferred.curves.x1 == serial.curves.x1;
+    printf("svg_parallel %2u threads   %8.2f ms  %7.1f MB/s  %s\n", Parallel::threadCount(), ms,
+           document.size() / 1e6 / (ms / 1000.0), same ? "identical" : "MISMATCH");
+}
+
+// Vertex memory of buildSVG's mesh for a 16 MB drawing: MeshVertex against PackedVertex, the
+// cost of packing and the largest position error it introduces.
+static void benchVertexPack() {
+    std::string path = writeLargeSvg(16u << 20);
+    SvgSegments svg = SvgSegments::fromFile(path.c_str());
+    std::filesystem::remove(path);
+    SvgMesh mesh = SvgMesh::build(svg);
+
+    auto start = std::chrono::steady_clock::now();
+    PackedMesh packed;
+    bool ok = PackedMesh::pack(mesh.vertices, packed);
+    double ms = elapsedMs(start);
+    float worst = 0.0f;
+    for (size_t i = 0; ok && i < mesh.vertices.size(); i++) {
+        MeshVertex v = packed.unpack(i);
+        worst = std::max({ worst, std::fabs(v.pos[0] - mesh.vertices[i].pos[0]), std::fabs(v.pos[1] - mesh.vertices[i].pos[1]) });
+    }
+    size_t fullBytes = mesh.vertices.size() * sizeof(MeshVertex);
+    size_t packedBytes = packed.vertices.size() * sizeof(PackedVertex) + packed.palette.size() * sizeof(PackedColor);
+    printf("vertex_pack %zu vertices  %.1f MB -> %.1f MB (%.1fx)  pack %.2f ms  %zu colors  max error %.2g NDC (%.3f px)\n",
+           mesh.vertices.size(), fullBytes / 1e6, packedBytes / 1e6, (double)fullBytes / packedBytes, ms, packed.palette.size(),
+           worst, worst * TessellationOptions().viewportPixels / 2);
+}
+
+// Mesh assembly for a 16 MB drawing: the loop SvgMesh::build replaced (a temporary point
+// vector per segment, push_back into growing outputs, indices built at 32 bits and narrowed at
+// the end) against build's count, prefix sum and in-place write, counting every heap
+// allocation. The old loop is replayed with build's classification and normal quads and
+// writes today's layout, one line strip per path then a quad strip per segment, so both sides
+// produce the same mesh.
+static void benchMeshAssembly() {
+    std::string path = writeLargeSvg(16u << 20);
+    SvgSegments svg = SvgSegments::fromFile(path.c_str());
+    std::filesystem::remove(path);
+    TessellationOptions options;
+    float div = std::max(svg.width, svg.height);
+    float tolerance = 2.0f * options.tolerancePixels / options.viewportPixels;
+    const uint32_t restart = 0xFFFFFFFF;
+
+    auto toNDC = [div](CubicSegment segment) {
+        for (Point2* point : { &segment.p0, &segment.p1, &segment.p2, &segment.p3 }) {
+            point->x = 2 * (point->x / div) - 1.0f;
+            point->y = 1.0f - 2 * (point->y / div);
+        }
+        return segment;
+    };
+    auto makeVertex = [](Point2 point, float red) {
+        MeshVertex v;
+        v.pos[0] = point.x;
+        v.pos[1] = point.y;
+        v.color[0] = red;
+        return v;
+    };
+    auto normal = [](const CubicSegment& c, float t) {
+        Point2 tangent = Bezier::derivative(c, t);
+        float length = std::sqrt(tangent.x * tangent.x + tangent.y * tangent.y);
+        return Point2{ -tangent.y / length, tangent.x / length };
+    };
+
+    size_t allocations = allocationCount, bytes = allocationBytes;
+    auto start = std::chrono::steady_clock::now();
+    size_t oldVertices = 0, oldIndices = 0;
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint16_t> indices16;
+        SegmentStats stats;
+        for (size_t first = 0; first < svg.size();) {
+            size_t end = first + 1;
+            while (end < svg.size() && svg.pathIds[end] == svg.pathIds[end - 1]) {
+                end++;
+            }
+            uint32_t index = (uint32_t)vertices.size();
+            for (size_t i = first; i < end; i++) {
+                SegmentKind kind = Bezier::classify(svg.get(i), tolerance * div / 2);
+                stats.add(kind);
+                std::vector<Point2> points;
+                Bezier::flattenByKind(toNDC(svg.get(i)), kind, tolerance, points, i == first);
+                for (const Point2& point : points) {
+                    vertices.push_back(makeVertex(point, 0.0f));
+                    indices.push_back(index++);
+                }
+            }
+            indices.push_back(restart);
+            // Red quad across the curve at both end points, closed back on its first vertex
+            for (size_t i = first; i < end; i++) {
+                CubicSegment c = toNDC(svg.get(i));
+                Point2 n0 = normal(c, 0.0f), n1 = normal(c, 1.0f);
+                float length = options.normalLength;
+                vertices.push_back(makeVertex({ c.p3.x + length * n1.x, c.p3.y + length * n1.y }, 1.0f));
+                vertices.push_back(makeVertex({ c.p0.x + length * n0.x, c.p0.y + length * n0.y }, 1.0f));
+                vertices.push_back(makeVertex({ c.p0.x - length * n0.x, c.p0.y - length * n0.y }, 1.0f));
+                vertices.push_back(makeVertex({ c.p3.x - length * n1.x, c.p3.y - length * n1.y }, 1.0f));
+                vertices.push_back(vertices[vertices.size() - 4]);
+                for (int k = 0; k < 5; k++) {
+                    indices.push_back(index++);
+                }
+                indices.push_back(restart);
+            }
+            first = end;
+        }
+        if (SvgMesh::indexTypeFor(vertices.size()) == MeshIndexType::UInt16) {
+            indices16.assign(indices.begin(), indices.end());
+            indices = std::vector<uint32_t>();
+        }
+        oldVertices = vertices.size();
+        oldIndices = indices.size() + indices16.size();
+    }
+    double oldMs = elapsedMs(start);
+    size_t oldAllocations = allocationCount - allocations, oldBytes = allocationBytes - bytes;
+
+    allocations = allocationCount;
+    bytes = allocationBytes;
+    start = std::chrono::steady_clock::now();
+    SvgMesh mesh = SvgMesh::build(svg, options);
+    double ms = elapsedMs(start);
+    size_t count = allocationCount - allocations;
+    if (oldVertices != mesh.vertices.size() || oldIndices != mesh.indexCount()) {
+        printf("mesh_assembly MISMATCH  push_back %zu vertices %zu indices, two-pass %zu vertices %zu indices\n",
+               oldVertices, oldIndices, mesh.vertices.size(), mesh.indexCount());
+        return;
+    }
+    printf("mesh_assembly push_back  %8.2f ms  %9zu allocations  %8.1f MB allocated  (%zu vertices, %zu indices)\n", oldMs,
+           oldAllocations, oldBytes / 1e6, oldVertices, oldIndices);
+    printf("mesh_assembly two-pass   %8.2f ms  %9zu allocations  %8.1f MB allocated  (%u threads, %.2g allocations per vertex)\n",
+           ms, count, (allocationBytes - bytes) / 1e6, Parallel::threadCount(), (double)count / std::max<size_t>(mesh.vertices.size(), 1));
+}
+
+// Stroke expansion of a 4 MB drawing: every path 6 px wide under each join and cap style,
+// then dashed.
+static void benchStroke() {
+    std::string path = writeLargeSvg(4u << 20);
+    NSVGimage* image = nsvgParseFromFile(path.c_str(), "px", 96);
+    std::filesystem::remove(path);
+    SvgSegments svg = SvgSegments::fromImage(image);
+    SvgStyles styles = SvgStyles::fromImage(image);
+    nsvgDelete(image);
+
+    struct Variant {
+        const char* name;
+        LineJoin join;
+        LineCap cap;
+        int dashCount;
+    };
+    const Variant variants[] = {
+        { "miter/butt", LineJoin::Miter, LineCap::Butt, 0 },
+        { "bevel/square", LineJoin::Bevel, LineCap::Square, 0 },
+        { "round/round", LineJoin::Round, LineCap::Round, 0 },
+        { "round/round dashed", LineJoin::Round, LineCap::Round, 2 },
+    };
+    for (const Variant& variant : variants) {
+        for (StrokeStyle& style : styles.strokes) {
+            style.width = 6.0f;
+            style.join = variant.join;
+            style.cap = variant.cap;
+            style.dashCount = variant.dashCount;
+            style.dashes[0] = 12.0f;
+            style.dashes[1] = 6.0f;
+        }
+        auto start = std::chrono::steady_clock::now();
+        StrokeMesh mesh = StrokeMesh::build(svg, styles);
+        double ms = elapsedMs(start);
+        printf("stroke %-20s %zu paths  %9zu vertices  %9zu triangles  %8.2f ms  %.1f M triangles/s\n", variant.name,
+               mesh.ranges.size(), mesh.vertices.size(), mesh.indexCount() / 3, ms, mesh.indexCount() / 3 / 1e3 / ms);
+    }
+}
+
+// Fill tessellation: every path of the 4 MB drawing filled under both rules (many small,
+// self-intersecting shapes), then one jagged 100k-edge outline with a hole.
+static void benchFill() {
+    std::string path = writeLargeSvg(4u << 20);
+    NSVGimage* image = nsvgParseFromFile(path.c_str(), "px", 96);
+    std::filesystem::remove(path);
+    SvgSegments svg = SvgSegments::fromImage(image);
+    SvgStyles styles = SvgStyles::fromImage(image);
+    nsvgDelete(image);
+    for (FillRule rule : { FillRule::NonZero, FillRule::EvenOdd }) {
+        for (FillStyle& style : styles.fills) {
+            style.filled = true;
+            style.rule = rule;
+        }
+        auto start = std::chrono::steady_clock::now();
+        FillMesh mesh = FillMesh::build(svg, styles);
+        double ms = elapsedMs(start);
+        printf("fill %-9s %zu shapes  %9zu vertices  %9zu triangles  %8.2f ms  %.1f M triangles/s\n",
+               rule == FillRule::NonZero ? "nonzero" : "evenodd", mesh.ranges.size(), mesh.vertices.size(),
+               mesh.indexCount() / 3, ms, mesh.indexCount() / 3 / 1e3 / ms);
+    }
+
+    const int edges = 100000;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> jitter(-3.0f, 3.0f);
+    std::string document = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\"><path fill=\"#f00\" d=\"";
+    char number[64];
+    for (int i = 0; i < edges; i++) {
+        float angle = 2.0f * (float)M_PI * i / edges;
+        float radius = 400.0f + 80.0f * std::sin(37.0f * angle) + jitter(rng);
+        snprintf(number, sizeof(number), "%c%.3f %.3f", i == 0 ? 'M' : 'L', 500.0f + radius * std::cos(angle), 500.0f + radius * std::sin(angle));
+        document += number;
+    }
+    document += "ZM400 400L400 600L600 600L600 400Z\"/></svg>";
+    image = nsvgParse(document.data(), "px", 96);
+    svg = SvgSegments::fromImage(image);
+    styles = SvgStyles::fromImage(image);
+    nsvgDelete(image);
+    auto start = std::chrono::steady_clock::now();
+    FillMesh mesh = FillMesh::build(svg, styles);
+    double ms = elapsedMs(start);
+    printf("fill %-9s %zu edges  %9zu vertices  %9zu triangles  %8.2f ms\n", "jagged", svg.size(), mesh.vertices.size(),
+           mesh.indexCount() / 3, ms);
+}
+
+int main(int argc, char* argv[]) {
+    const std::pair<const char*, std::function<void()>> cases[] = {
+        { "forward_difference", benchForwardDifference },
+        { "curve_frames", benchCurveFrames },
+        { "offset_curve", benchOffsetCurve },
+        { "closest_point", benchClosestPoint },
+        { "voronoi", benchVoronoi },
+        { "band_field", benchBandField },
+        { "svg_load", benchSvgLoad },
+        { "svg_parse", benchSvgParse },
+        { "svg_stream", benchSvgStream },
+        { "svg_image", benchSvgImage },
+        { "svg_cache", benchSvgCache },
+        { "svg_parallel", benchSvgParallel },
+        { "vertex_pack", benchVertexPack },
+        { "mesh_assembly", benchMeshAssembly },
+        { "stroke", benchStroke },
+        { "fill", benchFill },
+    };
+    for (const auto& [name, run] : cases) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            selected = selected || strcmp(argv[i], name) == 0;
+        }
+        if (selected) {
+            run();
+        }
+    }
+    return 0;
+}
@@ -24,9 +24,11 @@ struct Vertex {
         color = {0.0f, 0.0f, 0.0f};
     }
     
-    Vertex (std::vector<float> _pos, std::vector<float> _color)
+    // Takes the simd values directly, so brace lists like {{x, y}, {r, g, b}} build a
+    // Vertex without allocating
+    Vertex (simd::float2 _pos, simd::float3 _color)
     {
-        pos = {_pos[0], _pos[1]};
-        color = {_color[0], _color[1], _color[2]};
+        pos = _pos;
+        color = _color;
     }
 };
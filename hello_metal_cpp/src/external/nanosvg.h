@@ -29,6 +29,8 @@
 #ifndef NANOSVG_H
 #define NANOSVG_H
 
+#include <stddef.h>
+
 #ifndef NANOSVG_CPLUSPLUS
 #ifdef __cplusplus
 extern "C" {
@@ -164,6 +166,7 @@ typedef struct NSVGimage
     float width;                // Width of the image.
     float height;                // Height of the image.
     NSVGshape* shapes;            // Linked list of shapes in the image.
+    struct NSVGarenaBlock* storage;    // Memory of all shapes, paths, points and gradients, released by nsvgDelete.
 } NSVGimage;
 
 // Parses SVG file from a file, returns SVG image as paths.
@@ -173,6 +176,42 @@ NSVGimage* nsvgParseFromFile(const char* filename, const char* units, float dpi)
 // Important note: changes the string.
 NSVGimage* nsvgParse(char* input, const char* units, float dpi);
 
+// Parses size bytes of SVG from a caller-owned buffer, tokenizing it in place without a copy.
+// The buffer must hold at least size+1 bytes, data[size] is overwritten with the terminator.
+NSVGimage* nsvgParseBuffer(char* data, size_t size, const char* units, float dpi);
+
+// Receives geometry from nsvgParseGeometry as it is decoded. path gets each path's points
+// (1 + 3*N cubic control points, x,y interleaved) in user space with the element transforms
+// applied; the pointer is only valid during the call. shapeEnd follows the last path of every
+// shape that produced at least one path, so shapes are numbered as in NSVGimage::shapes.
+typedef struct NSVGgeometrySink
+{
+    void (*path)(void* ud, const float* pts, int npts, char closed);
+    void (*shapeEnd)(void* ud);
+    void* userdata;
+} NSVGgeometrySink;
+
+// Parses a null terminated string for geometry only: no shapes, paints or gradients are built,
+// paths are handed to sink and forgotten. Within a shape paths arrive in document order, which is
+// the reverse of NSVGshape::paths. The viewBox mapping nsvgParse would apply is returned in
+// view as [tx, ty, sx, sy, width, height]: x' = (x + tx) * sx, y' = (y + ty) * sy.
+// Returns 0 if the parser could not be allocated. Important note: changes the string.
+int nsvgParseGeometry(char* input, const char* units, float dpi, const NSVGgeometrySink* sink, float* view);
+
+// nsvgParseGeometry on a file, loaded the same way as by nsvgParseFromFile. Returns 0 if the
+// file cannot be read.
+int nsvgParseGeometryFromFile(const char* filename, const char* units, float dpi, const NSVGgeometrySink* sink, float* view);
+
+// Runs job(jobUd, i) for every i in [0, count) on any threads and returns once all are done.
+typedef void (*NSVGparallelFor)(void* ud, int count, void (*job)(void* jobUd, int index), void* jobUd);
+
+// Same result as nsvgParse, with the shape elements (path, rect, circle, ellipse, line,
+// polyline, polygon) parsed concurrently. A serial pre-scan tokenizes the document, handles
+// svg, g, defs and gradients, and records for every shape the inherited attributes and
+// viewport it sees; the shapes are then parsed in chunks through parallelFor. Pass NULL to run
+// the chunks on the calling thread. Important note: changes the string.
+NSVGimage* nsvgParseParallel(char* input, const char* units, float dpi, NSVGparallelFor parallelFor, void* ud);
+
 // Duplicates a path.
 NSVGpath* nsvgDuplicatePath(NSVGpath* p);
 
@@ -191,6 +230,17 @@ void nsvgDelete(NSVGimage* image);
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
+
+// nsvgParseFromFile maps the file instead of reading a copy where mmap is available.
+// Define NSVG_NO_MMAP to always use fread.
+#if !defined(NSVG_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define NSVG_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define NSVG_PI (3.14159265358979323846264338327f)
 #define NSVG_KAPPA90 (0.5522847493f)    // Length proportional to radius of a cubic bezier handle for 90deg arcs.
@@ -326,14 +376,22 @@ static void nsvg__parseElement(char* s,
         (*endelCb)(ud, name);
 }
 
-int nsvg__parseXML(char* input,
-                   void (*startelCb)(void* ud, const char* el, const char** attr),
-                   void (*endelCb)(void* ud, const char* el),
-                   void (*contentCb)(void* ud, const char* s),
-                   void* ud)
+// Every this many bytes of input the progress callback of nsvg__parseXMLProgress is told
+// how far parsing got.
+#define NSVG_XML_PROGRESS_BYTES (4 << 20)
+
+// nsvg__parseXML that also calls progressCb(progressUd, s) at element boundaries, at most
+// once per NSVG_XML_PROGRESS_BYTES; nothing before s is read again after the call.
+static int nsvg__parseXMLProgress(char* input,
+                                  void (*startelCb)(void* ud, const char* el, const char** attr),
+                                  void (*endelCb)(void* ud, const char* el),
+                                  void (*contentCb)(void* ud, const char* s),
+                                  void (*progressCb)(void* ud, char* s),
+                                  void* ud, void* progressUd)
 {
     char* s = input;
     char* mark = s;
+    char* reported = s;
     int state = NSVG_XML_CONTENT;
     while (*s) {
         if (*s == '<' && state == NSVG_XML_CONTENT) {
@@ -348,6 +406,10 @@ int nsvg__parseXML(char* input,
             nsvg__parseElement(mark, startelCb, endelCb, ud);
             mark = s;
             state = NSVG_XML_CONTENT;
+            if (progressCb && s - reported >= NSVG_XML_PROGRESS_BYTES) {
+                (*progressCb)(progressUd, s);
+                reported = s;
+            }
         } else {
             s++;
         }
@@ -356,6 +418,15 @@ int nsvg__parseXML(char* input,
     return 1;
 }
 
+int nsvg__parseXML(char* input,
+                   void (*startelCb)(void* ud, const char* el, const char** attr),
+                   void (*endelCb)(void* ud, const char* el),
+                   void (*contentCb)(void* ud, const char* s),
+                   void* ud)
+{
+    return nsvg__parseXMLProgress(input, startelCb, endelCb, contentCb, NULL, ud, NULL);
+}
+
 
 /* Simple SVG parser. */
 
@@ -439,6 +510,37 @@ typedef struct NSVGattrib
     char visible;
 } NSVGattrib;
 
+// Bump allocator blocks. Everything allocated from them lives until nsvgDelete frees the
+// whole chain, so shapes and paths are never freed one by one.
+typedef struct NSVGarenaBlock
+{
+    struct NSVGarenaBlock* next;
+    size_t size;
+    size_t used;
+} NSVGarenaBlock;
+
+// Attributes and viewport a deferred shape inherits, see nsvgParseParallel.
+typedef struct NSVGparseState
+{
+    NSVGattrib attr;
+    float viewMinx, viewMiny, viewWidth, viewHeight;
+} NSVGparseState;
+
+typedef struct NSVGdeferredShape
+{
+    const char* el;
+    int attr;        // First name of the attribute list in attrPool.
+    int state;
+    int nstyleRules;    // Style rules defined before the shape, the ones it sees.
+} NSVGdeferredShape;
+
+// Rule of a <style> element for one class selector, e.g. both ".a" and ".b" of ".a, .b {...}".
+typedef struct NSVGstyleRule
+{
+    int className;      // Offsets of NUL-terminated strings in styleText.
+    int declarations;
+} NSVGstyleRule;
+
 typedef struct NSVGparser
 {
     NSVGattrib attr[NSVG_MAX_ATTR];
@@ -455,6 +557,29 @@ typedef struct NSVGparser
     float dpi;
     char pathFlag;
     char defsFlag;
+    const NSVGgeometrySink* sink;    // Geometry-only mode, see nsvgParseGeometry.
+    float* xpts;                    // Transformed points of the path being handed to sink.
+    int cxpts;
+    int sinkPaths;                  // Paths emitted since the last shape.
+    float sinkBounds[4];
+    char sinkHasBounds;
+    NSVGarenaBlock* shapeBlock;    // Current block for shape and path structs.
+    NSVGarenaBlock* pointBlock;    // Current block for path points, consecutive paths end to end.
+    // Parallel pre-scan: shapes are recorded instead of parsed.
+    NSVGparseState* states;
+    int nstates, cstates;
+    int stateIds[NSVG_MAX_ATTR];    // Snapshot of each attribute level in states, -1 if changed since.
+    NSVGdeferredShape* deferred;
+    int ndeferred, cdeferred;
+    const char** attrPool;
+    int nattrPool, cattrPool;
+    char prescanFailed;
+    // Class rules of <style> elements, see nsvg__parseStyleSheet. Parallel workers borrow them.
+    char* styleText;
+    int nstyleText, cstyleText;
+    NSVGstyleRule* styleRules;
+    int nstyleRules, cstyleRules;
+    char styleFlag;
 } NSVGparser;
 
 static void nsvg__xformIdentity(float* t)
@@ -614,6 +739,52 @@ static void nsvg__curveBounds(float* bounds, float* curve)
     }
 }
 
+#define NSVG_ARENA_ALIGN 16
+#define NSVG_ARENA_MIN_BLOCK (16*1024)
+#define NSVG_ARENA_MAX_BLOCK (4*1024*1024)
+
+static size_t nsvg__arenaHeader(void)
+{
+    return (sizeof(NSVGarenaBlock) + NSVG_ARENA_ALIGN-1) & ~(size_t)(NSVG_ARENA_ALIGN-1);
+}
+
+// Returns size bytes aligned to align (a power of two up to NSVG_ARENA_ALIGN) from *current,
+// starting a new block in image->storage when it is full. Blocks double up to
+// NSVG_ARENA_MAX_BLOCK; larger requests get a block of their own so the current one keeps filling.
+static void* nsvg__arenaAlloc(NSVGimage* image, NSVGarenaBlock** current, size_t size, size_t align)
+{
+    NSVGarenaBlock* block = *current;
+    size_t offset = 0, blockSize;
+
+    if (block != NULL)
+        offset = (block->used + align-1) & ~(align-1);
+    if (block == NULL || offset + size > block->size) {
+        blockSize = block != NULL ? block->size*2 : NSVG_ARENA_MIN_BLOCK;
+        if (blockSize > NSVG_ARENA_MAX_BLOCK) blockSize = NSVG_ARENA_MAX_BLOCK;
+        if (size > blockSize/2) blockSize = size;
+        block = (NSVGarenaBlock*)malloc(nsvg__arenaHeader() + blockSize);
+        if (block == NULL) return NULL;
+        block->size = blockSize;
+        block->used = 0;
+        block->next = image->storage;
+        image->storage = block;
+        if (blockSize != size || *current == NULL)
+            *current = block;
+        offset = 0;
+    }
+    block->used = offset + size;
+    return (char*)block + nsvg__arenaHeader() + offset;
+}
+
+static void nsvg__arenaFree(NSVGarenaBlock* block)
+{
+    while (block != NULL) {
+        NSVGarenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
 static NSVGparser* nsvg__createParser(void)
 {
     NSVGparser* p;
@@ -652,23 +823,6 @@ error:
     return NULL;
 }
 
-static void nsvg__deletePaths(NSVGpath* path)
-{
-    while (path) {
-        NSVGpath *next = path->next;
-        if (path->pts != NULL)
-            free(path->pts);
-        free(path);
-        path = next;
-    }
-}
-
-static void nsvg__deletePaint(NSVGpaint* paint)
-{
-    if (paint->type == NSVG_PAINT_LINEAR_GRADIENT || paint->type == NSVG_PAINT_RADIAL_GRADIENT)
-        free(paint->gradient);
-}
-
 static void nsvg__deleteGradientData(NSVGgradientData* grad)
 {
     NSVGgradientData* next;
@@ -683,10 +837,16 @@ static void nsvg__deleteGradientData(NSVGgradientData* grad)
 static void nsvg__deleteParser(NSVGparser* p)
 {
     if (p != NULL) {
-        nsvg__deletePaths(p->plist);
+        // p->plist lives in the image's arena
         nsvg__deleteGradientData(p->gradients);
         nsvgDelete(p->image);
         free(p->pts);
+        free(p->xpts);
+        free(p->states);
+        free(p->deferred);
+        free(p->attrPool);
+        free(p->styleText);
+        free(p->styleRules);
         free(p);
     }
 }
@@ -849,7 +1009,7 @@ static NSVGgradient* nsvg__createGradient(NSVGparser* p, const char* id, const f
     }
     if (stops == NULL) return NULL;
 
-    grad = (NSVGgradient*)malloc(sizeof(NSVGgradient) + sizeof(NSVGgradientStop)*(nstops-1));
+    grad = (NSVGgradient*)nsvg__arenaAlloc(p->image, &p->shapeBlock, sizeof(NSVGgradient) + sizeof(NSVGgradientStop)*(nstops-1), NSVG_ARENA_ALIGN);
     if (grad == NULL) return NULL;
 
     // The shape width and height.
@@ -950,11 +1110,18 @@ static void nsvg__addShape(NSVGparser* p)
     NSVGpath* path;
     int i;
 
+    if (p->sink != NULL) {
+        if (p->sinkPaths > 0 && p->sink->shapeEnd != NULL)
+            p->sink->shapeEnd(p->sink->userdata);
+        p->sinkPaths = 0;
+        return;
+    }
+
     if (p->plist == NULL)
         return;
 
-    shape = (NSVGshape*)malloc(sizeof(NSVGshape));
-    if (shape == NULL) goto error;
+    shape = (NSVGshape*)nsvg__arenaAlloc(p->image, &p->shapeBlock, sizeof(NSVGshape), NSVG_ARENA_ALIGN);
+    if (shape == NULL) return;
     memset(shape, 0, sizeof(NSVGshape));
 
     memcpy(shape->id, attr->id, sizeof shape->id);
@@ -1019,11 +1186,44 @@ static void nsvg__addShape(NSVGparser* p)
     else
         p->shapesTail->next = shape;
     p->shapesTail = shape;
+}
 
-    return;
+// Geometry-only counterpart of the NSVGpath built below: transform into a reused buffer,
+// grow the document bounds and pass the points on.
+static void nsvg__emitPath(NSVGparser* p, char closed)
+{
+    NSVGattrib* attr = nsvg__getAttr(p);
+    float bounds[4];
+    int i;
 
-error:
-    if (shape) free(shape);
+    if (p->npts > p->cxpts) {
+        float* xpts = (float*)realloc(p->xpts, p->cpts*2*sizeof(float));
+        if (xpts == NULL) return;
+        p->xpts = xpts;
+        p->cxpts = p->cpts;
+    }
+    for (i = 0; i < p->npts; ++i)
+        nsvg__xformPoint(&p->xpts[i*2], &p->xpts[i*2+1], p->pts[i*2], p->pts[i*2+1], attr->xform);
+
+    for (i = 0; i < p->npts-1; i += 3) {
+        nsvg__curveBounds(bounds, &p->xpts[i*2]);
+        if (!p->sinkHasBounds) {
+            p->sinkBounds[0] = bounds[0];
+            p->sinkBounds[1] = bounds[1];
+            p->sinkBounds[2] = bounds[2];
+            p->sinkBounds[3] = bounds[3];
+            p->sinkHasBounds = 1;
+        } else {
+            p->sinkBounds[0] = nsvg__minf(p->sinkBounds[0], bounds[0]);
+            p->sinkBounds[1] = nsvg__minf(p->sinkBounds[1], bounds[1]);
+            p->sinkBounds[2] = nsvg__maxf(p->sinkBounds[2], bounds[2]);
+            p->sinkBounds[3] = nsvg__maxf(p->sinkBounds[3], bounds[3]);
+        }
+    }
+
+    if (p->sink->path != NULL)
+        p->sink->path(p->sink->userdata, p->xpts, p->npts, closed);
+    p->sinkPaths++;
 }
 
 static void nsvg__addPath(NSVGparser* p, char closed)
@@ -1044,12 +1244,17 @@ static void nsvg__addPath(NSVGparser* p, char closed)
     if ((p->npts % 3) != 1)
         return;
 
-    path = (NSVGpath*)malloc(sizeof(NSVGpath));
-    if (path == NULL) goto error;
+    if (p->sink != NULL) {
+        nsvg__emitPath(p, closed);
+        return;
+    }
+
+    path = (NSVGpath*)nsvg__arenaAlloc(p->image, &p->shapeBlock, sizeof(NSVGpath), NSVG_ARENA_ALIGN);
+    if (path == NULL) return;
     memset(path, 0, sizeof(NSVGpath));
 
-    path->pts = (float*)malloc(p->npts*2*sizeof(float));
-    if (path->pts == NULL) goto error;
+    path->pts = (float*)nsvg__arenaAlloc(p->image, &p->pointBlock, p->npts*2*sizeof(float), sizeof(float));
+    if (path->pts == NULL) return;
     path->closed = closed;
     path->npts = p->npts;
 
@@ -1076,14 +1281,6 @@ static void nsvg__addPath(NSVGparser* p, char closed)
 
     path->next = p->plist;
     p->plist = path;
-
-    return;
-
-error:
-    if (path != NULL) {
-        if (path->pts != NULL) free(path->pts);
-        free(path);
-    }
 }
 
 // We roll our own string to float because the std library one uses locale and messes things up.
@@ -1146,55 +1343,93 @@ static double nsvg__atof(const char* s)
 }
 
 
-static const char* nsvg__parseNumber(const char* s, char* it, const int size)
+// Powers of ten that are exact doubles; pow(10, n) returns the same values for these n.
+static const double nsvg__pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double nsvg__pow10d(long n)
 {
-    const int last = size-1;
-    int i = 0;
+    if (n >= 0 && n <= 22) return nsvg__pow10[n];
+    return pow(10.0, (double)n);
+}
+
+// Decimal digit sequence, saturating at LLONG_MAX like strtoll.
+static const char* nsvg__parseDigits(const char* s, long long* value)
+{
+    long long v = 0;
+    while (nsvg__isdigit(*s)) {
+        int d = *s++ - '0';
+        v = v > (LLONG_MAX - d) / 10 ? LLONG_MAX : v * 10 + d;
+    }
+    *value = v;
+    return s;
+}
+
+// Parses a number token in place, in a single pass and without copying it: consumes exactly
+// the characters of [sign] digits [. digits] [e [sign] digits], not taking the 'e' of em/ex
+// units, and computes the same value nsvg__atof computes for that token.
+static const char* nsvg__parseNumberValue(const char* s, double* value)
+{
+    const char* start;
+    double res = 0.0, sign = 1.0;
+    long long intPart = 0, fracPart = 0;
+    char hasIntPart = 0, hasFracPart = 0;
 
     // sign
     if (*s == '-' || *s == '+') {
-        if (i < last) it[i++] = *s;
+        if (*s == '-') sign = -1.0;
         s++;
     }
     // integer part
-    while (*s && nsvg__isdigit(*s)) {
-        if (i < last) it[i++] = *s;
-        s++;
+    if (nsvg__isdigit(*s)) {
+        s = nsvg__parseDigits(s, &intPart);
+        res = (double)intPart;
+        hasIntPart = 1;
     }
     if (*s == '.') {
-        // decimal point
-        if (i < last) it[i++] = *s;
+        // decimal point and fraction part
         s++;
-        // fraction part
-        while (*s && nsvg__isdigit(*s)) {
-            if (i < last) it[i++] = *s;
-            s++;
+        if (nsvg__isdigit(*s)) {
+            start = s;
+            s = nsvg__parseDigits(s, &fracPart);
+            res += (double)fracPart / nsvg__pow10d((long)(s - start));
+            hasFracPart = 1;
         }
     }
     // exponent
     if ((*s == 'e' || *s == 'E') && (s[1] != 'm' && s[1] != 'x')) {
-        if (i < last) it[i++] = *s;
+        long long expPart = 0;
+        char expNegative = 0;
         s++;
         if (*s == '-' || *s == '+') {
-            if (i < last) it[i++] = *s;
+            expNegative = *s == '-';
             s++;
         }
-        while (*s && nsvg__isdigit(*s)) {
-            if (i < last) it[i++] = *s;
-            s++;
+        if (nsvg__isdigit(*s) && (hasIntPart || hasFracPart)) {
+            long e;
+            s = nsvg__parseDigits(s, &expPart);
+            e = expPart > LONG_MAX ? LONG_MAX : (long)expPart;
+            res *= nsvg__pow10d(expNegative ? -e : e);
+        } else {
+            while (nsvg__isdigit(*s)) s++;
         }
     }
-    it[i] = '\0';
 
+    // A valid number should have integer or fractional part.
+    *value = (hasIntPart || hasFracPart) ? res * sign : 0.0;
     return s;
 }
 
-static const char* nsvg__getNextPathItemWhenArcFlag(const char* s, char* it)
+static const char* nsvg__getNextPathItemWhenArcFlag(const char* s, char* it, double* value)
 {
     it[0] = '\0';
+    *value = 0.0;
     while (*s && (nsvg__isspace(*s) || *s == ',')) s++;
     if (!*s) return s;
     if (*s == '0' || *s == '1') {
+        *value = *s == '1' ? 1.0 : 0.0;
         it[0] = *s++;
         it[1] = '\0';
         return s;
@@ -1202,14 +1437,21 @@ static const char* nsvg__getNextPathItemWhenArcFlag(const char* s, char* it)
     return s;
 }
 
-static const char* nsvg__getNextPathItem(const char* s, char* it)
+// Next command or number of path data. Commands are returned in it; for numbers it holds the
+// first two characters of the token (enough for nsvg__isCoordinate) and value the number.
+static const char* nsvg__getNextPathItem(const char* s, char* it, double* value)
 {
     it[0] = '\0';
+    *value = 0.0;
     // Skip white spaces and commas
     while (*s && (nsvg__isspace(*s) || *s == ',')) s++;
     if (!*s) return s;
     if (*s == '-' || *s == '+' || *s == '.' || nsvg__isdigit(*s)) {
-        s = nsvg__parseNumber(s, it, 64);
+        const char* start = s;
+        s = nsvg__parseNumberValue(s, value);
+        it[0] = start[0];
+        it[1] = s - start > 1 ? start[1] : '\0';
+        it[2] = '\0';
     } else {
         // Parse command
         it[0] = *s++;
@@ -1518,9 +1760,9 @@ static int nsvg__isCoordinate(const char* s)
 static NSVGcoordinate nsvg__parseCoordinateRaw(const char* str)
 {
     NSVGcoordinate coord = {0, NSVG_UNITS_USER};
-    char buf[64];
-    coord.units = nsvg__parseUnits(nsvg__parseNumber(str, buf, 64));
-    coord.value = nsvg__atof(buf);
+    double value;
+    coord.units = nsvg__parseUnits(nsvg__parseNumberValue(str, &value));
+    coord.value = (float)value;
     return coord;
 }
 
@@ -1540,7 +1782,6 @@ static int nsvg__parseTransformArgs(const char* str, float* args, int maxNa, int
 {
     const char* end;
     const char* ptr;
-    char it[64];
 
     *na = 0;
     ptr = str;
@@ -1555,8 +1796,9 @@ static int nsvg__parseTransformArgs(const char* str, float* args, int maxNa, int
     while (ptr < end) {
         if (*ptr == '-' || *ptr == '+' || *ptr == '.' || nsvg__isdigit(*ptr)) {
             if (*na >= maxNa) return 0;
-            ptr = nsvg__parseNumber(ptr, it, 64);
-            args[(*na)++] = (float)nsvg__atof(it);
+            double value;
+            ptr = nsvg__parseNumberValue(ptr, &value);
+            args[(*na)++] = (float)value;
         } else {
             ++ptr;
         }
@@ -2265,6 +2507,7 @@ static void nsvg__parsePath(NSVGparser* p, const char** attr)
     char closedFlag;
     int i;
     char item[64];
+    double value;
 
     for (i = 0; attr[i]; i += 2) {
         if (strcmp(attr[i], "d") == 0) {
@@ -2289,13 +2532,13 @@ static void nsvg__parsePath(NSVGparser* p, const char** attr)
         while (*s) {
             item[0] = '\0';
             if ((cmd == 'A' || cmd == 'a') && (nargs == 3 || nargs == 4))
-                s = nsvg__getNextPathItemWhenArcFlag(s, item);
+                s = nsvg__getNextPathItemWhenArcFlag(s, item, &value);
             if (!*item)
-                s = nsvg__getNextPathItem(s, item);
+                s = nsvg__getNextPathItem(s, item, &value);
             if (!*item) break;
             if (cmd != '\0' && nsvg__isCoordinate(item)) {
                 if (nargs < 10)
-                    args[nargs++] = (float)nsvg__atof(item);
+                    args[nargs++] = (float)value;
                 if (nargs >= rargs) {
                     switch (cmd) {
                         case 'm':
@@ -2552,6 +2795,7 @@ static void nsvg__parsePoly(NSVGparser* p, const char** attr, int closeFlag)
     float args[2];
     int nargs, npts = 0;
     char item[64];
+    double value;
 
     nsvg__resetPath(p);
 
@@ -2561,8 +2805,8 @@ static void nsvg__parsePoly(NSVGparser* p, const char** attr, int closeFlag)
                 s = attr[i + 1];
                 nargs = 0;
                 while (*s) {
-                    s = nsvg__getNextPathItem(s, item);
-                    args[nargs++] = (float)nsvg__atof(item);
+                    s = nsvg__getNextPathItem(s, item, &value);
+                    args[nargs++] = (float)value;
                     if (nargs >= 2) {
                         if (npts == 0)
                             nsvg__moveTo(p, args[0], args[1]);
@@ -2592,21 +2836,21 @@ static void nsvg__parseSVG(NSVGparser* p, const char** attr)
                 p->image->height = nsvg__parseCoordinate(p, attr[i + 1], 0.0f, 0.0f);
             } else if (strcmp(attr[i], "viewBox") == 0) {
                 const char *s = attr[i + 1];
-                char buf[64];
-                s = nsvg__parseNumber(s, buf, 64);
-                p->viewMinx = nsvg__atof(buf);
+                double value;
+                s = nsvg__parseNumberValue(s, &value);
+                p->viewMinx = (float)value;
                 while (*s && (nsvg__isspace(*s) || *s == '%' || *s == ',')) s++;
                 if (!*s) return;
-                s = nsvg__parseNumber(s, buf, 64);
-                p->viewMiny = nsvg__atof(buf);
+                s = nsvg__parseNumberValue(s, &value);
+                p->viewMiny = (float)value;
                 while (*s && (nsvg__isspace(*s) || *s == '%' || *s == ',')) s++;
                 if (!*s) return;
-                s = nsvg__parseNumber(s, buf, 64);
-                p->viewWidth = nsvg__atof(buf);
+                s = nsvg__parseNumberValue(s, &value);
+                p->viewWidth = (float)value;
                 while (*s && (nsvg__isspace(*s) || *s == '%' || *s == ',')) s++;
                 if (!*s) return;
-                s = nsvg__parseNumber(s, buf, 64);
-                p->viewHeight = nsvg__atof(buf);
+                s = nsvg__parseNumberValue(s, &value);
+                p->viewHeight = (float)value;
             } else if (strcmp(attr[i], "preserveAspectRatio") == 0) {
                 if (strstr(attr[i + 1], "none") != 0) {
                     // No uniform scaling
@@ -2748,9 +2992,170 @@ static void nsvg__parseGradientStop(NSVGparser* p, const char** attr)
     stop->offset = curAttr->stopOffset;
 }
 
+static int nsvg__reserve(void** items, int* capacity, int count, size_t itemSize)
+{
+    int cap = *capacity;
+    void* grown;
+    if (count <= cap) return 1;
+    while (cap < count) cap = cap ? cap*2 : 64;
+    grown = realloc(*items, cap*itemSize);
+    if (grown == NULL) return 0;
+    *items = grown;
+    *capacity = cap;
+    return 1;
+}
+
+// Appends [s, end) without CSS comments to styleText as one string; its offset, -1 if out of
+// memory.
+static int nsvg__addStyleText(NSVGparser* p, const char* s, const char* end)
+{
+    int offset = p->nstyleText;
+    if (!nsvg__reserve((void**)&p->styleText, &p->cstyleText, p->nstyleText + (int)(end - s) + 1, 1))
+        return -1;
+    while (s < end) {
+        if (s[0] == '/' && s+1 < end && s[1] == '*') {
+            for (s += 2; s < end && !(s[0] == '*' && s+1 < end && s[1] == '/'); s++);
+            s = s < end ? s+2 : end;
+            continue;
+        }
+        p->styleText[p->nstyleText++] = *s++;
+    }
+    p->styleText[p->nstyleText++] = '\0';
+    return offset;
+}
+
+static int nsvg__isClassChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || nsvg__isdigit(c) || c == '-' || c == '_';
+}
+
+// Rules of a <style> element's text. Only plain class selectors are kept, alone or in a list
+// (".a", ".a, .b"); type, id, compound and descendant selectors and at-rules are skipped, and
+// !important is not understood.
+static void nsvg__parseStyleSheet(NSVGparser* p, const char* s)
+{
+    const char* selectors;
+    const char* block;
+    const char* blockEnd;
+    const char* item;
+    const char* itemEnd;
+    const char* selectorEnd;
+    const char* c;
+    int declarations, name, depth;
+    NSVGstyleRule* rule;
+
+    for (;;) {
+        // Skip white space and comments before the selectors
+        for (;;) {
+            while (*s && nsvg__isspace(*s)) s++;
+            if (s[0] != '/' || s[1] != '*') break;
+            s = strstr(s+2, "*/");
+            if (s == NULL) return;
+            s += 2;
+        }
+        if (!*s) return;
+        selectors = s;
+        while (*s && *s != '{') s++;
+        if (!*s) return;
+        block = ++s;
+        // At-rules nest blocks
+        for (depth = 1; *s && depth > 0; s++) {
+            if (*s == '{') depth++;
+            else if (*s == '}') depth--;
+        }
+        blockEnd = depth == 0 ? s-1 : s;
+        if (*selectors == '@') continue;
+
+        declarations = -1;
+        for (item = selectors; item < block-1; item = itemEnd+1) {
+            for (itemEnd = item; itemEnd < block-1 && *itemEnd != ','; itemEnd++);
+            while (item < itemEnd && nsvg__isspace(*item)) item++;
+            for (selectorEnd = itemEnd; selectorEnd > item && nsvg__isspace(selectorEnd[-1]); selectorEnd--);
+            if (selectorEnd - item < 2 || *item != '.') continue;
+            for (c = item+1; c < selectorEnd && nsvg__isClassChar(*c); c++);
+            if (c != selectorEnd) continue;
+            if (declarations < 0 && (declarations = nsvg__addStyleText(p, block, blockEnd)) < 0) return;
+            if ((name = nsvg__addStyleText(p, item+1, selectorEnd)) < 0) return;
+            if (!nsvg__reserve((void**)&p->styleRules, &p->cstyleRules, p->nstyleRules+1, sizeof(NSVGstyleRule))) return;
+            rule = &p->styleRules[p->nstyleRules++];
+            rule->className = name;
+            rule->declarations = declarations;
+        }
+    }
+}
+
+// Whether the white space separated list of classes holds name.
+static int nsvg__hasClass(const char* classes, const char* name)
+{
+    size_t n = strlen(name);
+    const char* start;
+    while (*classes) {
+        while (*classes && nsvg__isspace(*classes)) classes++;
+        start = classes;
+        while (*classes && !nsvg__isspace(*classes)) classes++;
+        if ((size_t)(classes - start) == n && strncmp(start, name, n) == 0) return 1;
+    }
+    return 0;
+}
+
+#define NSVG_MAX_STYLE_MATCHES 64
+
+// attr with the style rules matching the element's classes added as style attributes, in
+// styled: after its presentation attributes and before its own style attribute, the order in
+// which CSS lets them override each other. attr itself when no rule matches.
+static const char** nsvg__styledAttribs(NSVGparser* p, const char** attr, const char** styled)
+{
+    const char* classes = NULL;
+    int i, r, n = 0, matches = 0;
+
+    if (p->nstyleRules == 0) return attr;
+    for (i = 0; attr[i]; i += 2) {
+        if (strcmp(attr[i], "class") == 0)
+            classes = attr[i + 1];
+    }
+    if (classes == NULL) return attr;
+
+    for (i = 0; attr[i]; i += 2) {
+        if (strcmp(attr[i], "style") != 0) {
+            styled[n++] = attr[i];
+            styled[n++] = attr[i + 1];
+        }
+    }
+    for (r = 0; r < p->nstyleRules && matches < NSVG_MAX_STYLE_MATCHES; r++) {
+        if (nsvg__hasClass(classes, p->styleText + p->styleRules[r].className)) {
+            styled[n++] = "style";
+            styled[n++] = p->styleText + p->styleRules[r].declarations;
+            matches++;
+        }
+    }
+    if (matches == 0) return attr;
+    for (i = 0; attr[i]; i += 2) {
+        if (strcmp(attr[i], "style") == 0) {
+            styled[n++] = attr[i];
+            styled[n++] = attr[i + 1];
+        }
+    }
+    styled[n++] = 0;
+    styled[n++] = 0;
+    return styled;
+}
+
 static void nsvg__startElement(void* ud, const char* el, const char** attr)
 {
     NSVGparser* p = (NSVGparser*)ud;
+    const char* styled[NSVG_XML_MAX_ATTRIBS + 2*NSVG_MAX_STYLE_MATCHES];
+
+    if (strcmp(el, "style") == 0) {
+        p->styleFlag = 1;
+        return;
+    }
+    attr = nsvg__styledAttribs(p, attr, styled);
+
+    if (p->sink != NULL && (p->defsFlag || strcmp(el, "linearGradient") == 0 ||
+                            strcmp(el, "radialGradient") == 0 || strcmp(el, "stop") == 0)) {
+        // Paint servers are never used in geometry-only mode
+        return;
+    }
 
     if (p->defsFlag) {
         // Skip everything but gradients in defs
@@ -2820,14 +3225,196 @@ static void nsvg__endElement(void* ud, const char* el)
         p->pathFlag = 0;
     } else if (strcmp(el, "defs") == 0) {
         p->defsFlag = 0;
+    } else if (strcmp(el, "style") == 0) {
+        p->styleFlag = 0;
     }
 }
 
 static void nsvg__content(void* ud, const char* s)
 {
-    NSVG_NOTUSED(ud);
-    NSVG_NOTUSED(s);
-    // empty
+    NSVGparser* p = (NSVGparser*)ud;
+    if (p->styleFlag)
+        nsvg__parseStyleSheet(p, s);
+}
+
+#define NSVG_PARALLEL_CHUNK_BYTES (256*1024)
+
+static int nsvg__isShapeElement(const char* el)
+{
+    return strcmp(el, "path") == 0 || strcmp(el, "rect") == 0 || strcmp(el, "circle") == 0 ||
+           strcmp(el, "ellipse") == 0 || strcmp(el, "line") == 0 || strcmp(el, "polyline") == 0 ||
+           strcmp(el, "polygon") == 0;
+}
+
+// Index of the snapshot of the current attribute level, taken on first use after a change.
+static int nsvg__currentState(NSVGparser* p)
+{
+    NSVGparseState* state;
+    if (p->stateIds[p->attrHead] >= 0)
+        return p->stateIds[p->attrHead];
+    if (!nsvg__reserve((void**)&p->states, &p->cstates, p->nstates+1, sizeof(NSVGparseState)))
+        return -1;
+    state = &p->states[p->nstates];
+    memcpy(&state->attr, nsvg__getAttr(p), sizeof(NSVGattrib));
+    state->viewMinx = p->viewMinx;
+    state->viewMiny = p->viewMiny;
+    state->viewWidth = p->viewWidth;
+    state->viewHeight = p->viewHeight;
+    p->stateIds[p->attrHead] = p->nstates;
+    return p->nstates++;
+}
+
+static void nsvg__deferShape(NSVGparser* p, const char* el, const char** attr)
+{
+    NSVGdeferredShape* shape;
+    int i, n = 0, state;
+
+    while (attr[n]) n += 2;
+    state = nsvg__currentState(p);
+    if (state < 0 ||
+        !nsvg__reserve((void**)&p->attrPool, &p->cattrPool, p->nattrPool + n+2, sizeof(const char*)) ||
+        !nsvg__reserve((void**)&p->deferred, &p->cdeferred, p->ndeferred+1, sizeof(NSVGdeferredShape))) {
+        p->prescanFailed = 1;
+        return;
+    }
+    shape = &p->deferred[p->ndeferred++];
+    shape->el = el;
+    shape->attr = p->nattrPool;
+    shape->state = state;
+    shape->nstyleRules = p->nstyleRules;
+    // The tokenizer already terminated every name and value in place, the pointers stay valid.
+    for (i = 0; i < n+2; i++)
+        p->attrPool[p->nattrPool++] = attr[i];
+}
+
+static void nsvg__prescanStartElement(void* ud, const char* el, const char** attr)
+{
+    NSVGparser* p = (NSVGparser*)ud;
+    int i;
+
+    // Shapes only read the attribute stack and viewport, everything else runs now.
+    if (!p->defsFlag && nsvg__isShapeElement(el)) {
+        nsvg__deferShape(p, el, attr);
+        return;
+    }
+    nsvg__startElement(ud, el, attr);
+
+    // <svg> changes the viewport every later shape resolves units against; <g> fills a freshly
+    // pushed level, and other elements (e.g. stop) may write to the current one.
+    if (strcmp(el, "svg") == 0) {
+        for (i = 0; i <= p->attrHead; i++)
+            p->stateIds[i] = -1;
+    } else {
+        p->stateIds[p->attrHead] = -1;
+    }
+}
+
+typedef struct NSVGparallelParse
+{
+    NSVGparser* p;
+    int* chunkStart;        // nchunks+1 entries into p->deferred
+    NSVGparser** workers;    // Shapes and arena of each chunk, NULL if it failed.
+} NSVGparallelParse;
+
+static void nsvg__parseChunk(void* ud, int index)
+{
+    NSVGparallelParse* pp = (NSVGparallelParse*)ud;
+    NSVGparser* p = pp->p;
+    NSVGparser* w;
+    NSVGdeferredShape* shape;
+    NSVGparseState* state;
+    int i, current = -1;
+
+    w = nsvg__createParser();
+    if (w == NULL) return;
+    w->dpi = p->dpi;
+    w->styleText = p->styleText;
+    w->styleRules = p->styleRules;
+    for (i = pp->chunkStart[index]; i < pp->chunkStart[index+1]; i++) {
+        shape = &p->deferred[i];
+        if (shape->state != current) {
+            state = &p->states[shape->state];
+            memcpy(&w->attr[0], &state->attr, sizeof(NSVGattrib));
+            w->viewMinx = state->viewMinx;
+            w->viewMiny = state->viewMiny;
+            w->viewWidth = state->viewWidth;
+            w->viewHeight = state->viewHeight;
+            current = shape->state;
+        }
+        w->attrHead = 0;
+        w->nstyleRules = shape->nstyleRules;
+        nsvg__startElement(w, shape->el, &p->attrPool[shape->attr]);
+    }
+    pp->workers[index] = w;
+}
+
+// Parses the shapes recorded by the pre-scan and appends them, in document order, to p->image.
+static int nsvg__parseDeferred(NSVGparser* p, NSVGparallelFor parallelFor, void* ud)
+{
+    NSVGparallelParse pp;
+    NSVGparser* w;
+    NSVGarenaBlock* tail;
+    size_t bytes = 0;
+    int i, nchunks = 0, ok = 1;
+
+    if (p->prescanFailed) return 0;
+    if (p->ndeferred == 0) return 1;
+
+    // Chunks of roughly NSVG_PARALLEL_CHUNK_BYTES of source each
+    pp.p = p;
+    pp.chunkStart = (int*)malloc((p->ndeferred+1)*sizeof(int));
+    pp.workers = NULL;
+    if (pp.chunkStart == NULL) return 0;
+    pp.chunkStart[nchunks++] = 0;
+    for (i = 1; i < p->ndeferred; i++) {
+        bytes += (size_t)(p->deferred[i].el - p->deferred[i-1].el);
+        if (bytes >= NSVG_PARALLEL_CHUNK_BYTES) {
+            pp.chunkStart[nchunks++] = i;
+            bytes = 0;
+        }
+    }
+    pp.chunkStart[nchunks] = p->ndeferred;
+
+    pp.workers = (NSVGparser**)calloc(nchunks, sizeof(NSVGparser*));
+    if (pp.workers == NULL) {
+        free(pp.chunkStart);
+        return 0;
+    }
+    if (parallelFor != NULL) {
+        parallelFor(ud, nchunks, nsvg__parseChunk, &pp);
+    } else {
+        for (i = 0; i < nchunks; i++)
+            nsvg__parseChunk(&pp, i);
+    }
+
+    // Splice every chunk's shapes and arena blocks into the image
+    for (i = 0; i < nchunks; i++) {
+        w = pp.workers[i];
+        if (w == NULL) {
+            ok = 0;
+            continue;
+        }
+        if (w->image->shapes != NULL) {
+            if (p->image->shapes == NULL)
+                p->image->shapes = w->image->shapes;
+            else
+                p->shapesTail->next = w->image->shapes;
+            p->shapesTail = w->shapesTail;
+            w->image->shapes = NULL;
+        }
+        if (w->image->storage != NULL) {
+            for (tail = w->image->storage; tail->next != NULL; tail = tail->next);
+            tail->next = p->image->storage;
+            p->image->storage = w->image->storage;
+            w->image->storage = NULL;
+        }
+        w->styleText = NULL;    // Borrowed from p
+        w->styleRules = NULL;
+        nsvg__deleteParser(w);
+    }
+    free(pp.workers);
+    free(pp.chunkStart);
+    return ok;
 }
 
 static void nsvg__imageBounds(NSVGparser* p, float* bounds)
@@ -2870,16 +3457,11 @@ static void nsvg__scaleGradient(NSVGgradient* grad, float tx, float ty, float sx
     nsvg__xformMultiply (grad->xform, t);
 }
 
-static void nsvg__scaleToViewbox(NSVGparser* p, const char* units)
+// Mapping from user space to the viewport, view = [tx, ty, sx, sy]. Fills in the image size
+// from bounds when the document does not set it completely.
+static void nsvg__viewTransform(NSVGparser* p, const char* units, const float* bounds, float* view)
 {
-    NSVGshape* shape;
-    NSVGpath* path;
-    float tx, ty, sx, sy, us, bounds[4], t[6], avgs;
-    int i;
-    float* pt;
-
-    // Guess image size if not set completely.
-    nsvg__imageBounds(p, bounds);
+    float tx, ty, sx, sy, us;
 
     if (p->viewWidth == 0) {
         if (p->image->width > 0) {
@@ -2922,9 +3504,29 @@ static void nsvg__scaleToViewbox(NSVGparser* p, const char* units)
         ty += nsvg__viewAlign(p->viewHeight*sy, p->image->height, p->alignY) / sy;
     }
 
+    view[0] = tx;
+    view[1] = ty;
+    view[2] = sx * us;
+    view[3] = sy * us;
+}
+
+static void nsvg__scaleToViewbox(NSVGparser* p, const char* units)
+{
+    NSVGshape* shape;
+    NSVGpath* path;
+    float tx, ty, sx, sy, bounds[4], view[4], t[6], avgs;
+    int i;
+    float* pt;
+
+    // Guess image size if not set completely.
+    nsvg__imageBounds(p, bounds);
+    nsvg__viewTransform(p, units, bounds, view);
+    tx = view[0];
+    ty = view[1];
+    sx = view[2];
+    sy = view[3];
+
     // Transform
-    sx *= us;
-    sy *= us;
     avgs = (sx+sy) / 2.0f;
     for (shape = p->image->shapes; shape != NULL; shape = shape->next) {
         shape->bounds[0] = (shape->bounds[0] + tx) * sx;
@@ -2991,39 +3593,109 @@ static void nsvg__createGradients(NSVGparser* p)
     }
 }
 
+// What one parse produces: an image, or with a sink set, only the viewBox mapping.
+typedef struct NSVGparseJob {
+    const char* units;
+    float dpi;
+    const NSVGgeometrySink* sink;
+    float* view;
+    NSVGimage* image;
+} NSVGparseJob;
+
+static int nsvg__parseProgress(char* input, NSVGparseJob* job,
+                               void (*progressCb)(void* ud, char* s), void* progressUd)
+{
+    NSVGparser* p;
+    float bounds[4] = {0, 0, 0, 0};
+
+    p = nsvg__createParser();
+    if (p == NULL) {
+        return 0;
+    }
+    p->dpi = job->dpi;
+    p->sink = job->sink;
+
+    nsvg__parseXMLProgress(input, nsvg__startElement, nsvg__endElement, nsvg__content, progressCb, p, progressUd);
+
+    if (p->sink != NULL) {
+        if (p->sinkHasBounds)
+            memcpy(bounds, p->sinkBounds, sizeof(bounds));
+        nsvg__viewTransform(p, job->units, bounds, job->view);
+        job->view[4] = p->image->width;
+        job->view[5] = p->image->height;
+    } else {
+        // Create gradients after all definitions have been parsed
+        nsvg__createGradients(p);
+
+        // Scale to viewBox
+        nsvg__scaleToViewbox(p, job->units);
+
+        job->image = p->image;
+        p->image = NULL;
+    }
+
+    nsvg__deleteParser(p);
+
+    return 1;
+}
+
 NSVGimage* nsvgParse(char* input, const char* units, float dpi)
+{
+    NSVGparseJob job = {units, dpi, NULL, NULL, NULL};
+    nsvg__parseProgress(input, &job, NULL, NULL);
+    return job.image;
+}
+
+NSVGimage* nsvgParseParallel(char* input, const char* units, float dpi, NSVGparallelFor parallelFor, void* ud)
 {
     NSVGparser* p;
-    NSVGimage* ret = 0;
+    NSVGimage* ret = NULL;
+    int i;
 
     p = nsvg__createParser();
     if (p == NULL) {
         return NULL;
     }
     p->dpi = dpi;
+    for (i = 0; i < NSVG_MAX_ATTR; i++)
+        p->stateIds[i] = -1;
 
-    nsvg__parseXML(input, nsvg__startElement, nsvg__endElement, nsvg__content, p);
+    nsvg__parseXML(input, nsvg__prescanStartElement, nsvg__endElement, nsvg__content, p);
 
-    // Create gradients after all definitions have been parsed
-    nsvg__createGradients(p);
+    if (nsvg__parseDeferred(p, parallelFor, ud)) {
+        // Create gradients after all definitions have been parsed
+        nsvg__createGradients(p);
 
-    // Scale to viewBox
-    nsvg__scaleToViewbox(p, units);
+        // Scale to viewBox
+        nsvg__scaleToViewbox(p, units);
 
-    ret = p->image;
-    p->image = NULL;
+        ret = p->image;
+        p->image = NULL;
+    }
 
     nsvg__deleteParser(p);
 
     return ret;
 }
 
-NSVGimage* nsvgParseFromFile(const char* filename, const char* units, float dpi)
+NSVGimage* nsvgParseBuffer(char* data, size_t size, const char* units, float dpi)
+{
+    data[size] = '\0';
+    return nsvgParse(data, units, dpi);
+}
+
+int nsvgParseGeometry(char* input, const char* units, float dpi, const NSVGgeometrySink* sink, float* view)
+{
+    NSVGparseJob job = {units, dpi, sink, view, NULL};
+    return nsvg__parseProgress(input, &job, NULL, NULL);
+}
+
+static int nsvg__parseFromFileRead(const char* filename, NSVGparseJob* job)
 {
     FILE* fp = NULL;
     size_t size;
     char* data = NULL;
-    NSVGimage* image = NULL;
+    int ok;
 
     fp = fopen(filename, "rb");
     if (!fp) goto error;
@@ -3033,18 +3705,102 @@ NSVGimage* nsvgParseFromFile(const char* filename, const char* units, float dpi)
     data = (char*)malloc(size+1);
     if (data == NULL) goto error;
     if (fread(data, 1, size, fp) != size) goto error;
-    data[size] = '\0';    // Must be null terminated.
     fclose(fp);
-    image = nsvgParse(data, units, dpi);
+    data[size] = '\0';
+    ok = nsvg__parseProgress(data, job, NULL, NULL);
     free(data);
 
-    return image;
+    return ok;
 
 error:
     if (fp) fclose(fp);
     if (data) free(data);
-    if (image) nsvgDelete(image);
-    return NULL;
+    return 0;
+}
+
+#ifdef NSVG_USE_MMAP
+typedef struct NSVGmapping {
+    char* released;    // pages before this are already given back
+    size_t pageSize;
+} NSVGmapping;
+
+// Pages the tokenizer has written to are private copies. Once parsing is past them they are
+// replaced by an empty anonymous mapping, so the copies never add up to the whole file.
+static void nsvg__releaseParsed(void* ud, char* s)
+{
+    NSVGmapping* m = (NSVGmapping*)ud;
+    size_t len = (size_t)(s - m->released) / m->pageSize * m->pageSize;
+    if (len == 0) return;
+    if (mmap(m->released, len, PROT_READ, MAP_PRIVATE | MAP_ANON | MAP_FIXED, -1, 0) != MAP_FAILED)
+        m->released += len;
+}
+
+// Maps the file copy-on-write so the in-place tokenizer can write to it without touching the
+// file or copying it up front. The mapping sits at the start of a zeroed anonymous
+// reservation one byte longer than the file, which provides the terminator even when the
+// size is a multiple of the page size.
+static int nsvg__parseFromFileMapped(const char* filename, NSVGparseJob* job)
+{
+    int fd = -1;
+    struct stat st;
+    size_t size, mapSize = 0;
+    char* data = (char*)MAP_FAILED;
+    NSVGmapping mapping;
+    int ok;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) != 0) goto error;
+    if (!S_ISREG(st.st_mode)) {
+        // Pipes and devices cannot be mapped
+        close(fd);
+        return nsvg__parseFromFileRead(filename, job);
+    }
+    size = (size_t)st.st_size;
+    mapping.pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    mapSize = (size + 1 + mapping.pageSize - 1) / mapping.pageSize * mapping.pageSize;
+    data = (char*)mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (data == (char*)MAP_FAILED) goto error;
+    if (size > 0) {
+        if (mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) goto error;
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    fd = -1;
+
+    data[size] = '\0';
+    mapping.released = data;
+    ok = nsvg__parseProgress(data, job, nsvg__releaseParsed, &mapping);
+    munmap(data, mapSize);
+    return ok;
+
+error:
+    if (fd >= 0) close(fd);
+    if (data != (char*)MAP_FAILED) munmap(data, mapSize);
+    return 0;
+}
+#endif
+
+static int nsvg__parseFile(const char* filename, NSVGparseJob* job)
+{
+#ifdef NSVG_USE_MMAP
+    return nsvg__parseFromFileMapped(filename, job);
+#else
+    return nsvg__parseFromFileRead(filename, job);
+#endif
+}
+
+NSVGimage* nsvgParseFromFile(const char* filename, const char* units, float dpi)
+{
+    NSVGparseJob job = {units, dpi, NULL, NULL, NULL};
+    nsvg__parseFile(filename, &job);
+    return job.image;
+}
+
+int nsvgParseGeometryFromFile(const char* filename, const char* units, float dpi, const NSVGgeometrySink* sink, float* view)
+{
+    NSVGparseJob job = {units, dpi, sink, view, NULL};
+    return nsvg__parseFile(filename, &job);
 }
 
 NSVGpath* nsvgDuplicatePath(NSVGpath* p)
@@ -3079,17 +3835,9 @@ error:
 
 void nsvgDelete(NSVGimage* image)
 {
-    NSVGshape *snext, *shape;
     if (image == NULL) return;
-    shape = image->shapes;
-    while (shape != NULL) {
-        snext = shape->next;
-        nsvg__deletePaths(shape->paths);
-        nsvg__deletePaint(&shape->fill);
-        nsvg__deletePaint(&shape->stroke);
-        free(shape);
-        shape = snext;
-    }
+    // Shapes, paths, points and gradients all live in the arena
+    nsvg__arenaFree(image->storage);
     free(image);
 }
 
@@ -0,0 +1,102 @@
+#include "arc_length.h"
+#include <algorithm>
+#include <cmath>
+
+// 5-point Gauss-Legendre nodes and weights on [-1, 1]
+static const float kGaussNodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+static const float kGaussWeights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
+ArcLengthSegment::ArcLengthSegment(const CubicSegment& segment, int intervals)
+: curve(segment), resolution(std::clamp(intervals, 1, kMaxResolution)) {
+    cumulative[0] = 0.0f;
+    for (int i = 0; i < resolution; i++) {
+        cumulative[i + 1] = cumulative[i] + integrate(1.0f * i / resolution, 1.0f * (i + 1) / resolution);
+    }
+}
+
+float ArcLengthSegment::speed(float t) const {
+    Point2 d = Bezier::derivative(curve, t);
+    return std::sqrt(d.x * d.x + d.y * d.y);
+}
+
+float ArcLengthSegment::integrate(float t0, float t1) const {
+    float half = 0.5f * (t1 - t0);
+    float mid = 0.5f * (t1 + t0);
+    float sum = 0.0f;
+    for (int k = 0; k < 5; k++) {
+        sum += kGaussWeights[k] * speed(mid + half * kGaussNodes[k]);
+    }
+    return sum * half;
+}
+
+float ArcLengthSegment::lengthAt(float t) const {
+    if (resolution == 0) {
+        return 0.0f;
+    }
+    t = std::clamp(t, 0.0f, 1.0f);
+    int i = std::min((int)(t * resolution), resolution - 1);
+    return cumulative[i] + integrate(1.0f * i / resolution, t);
+}
+
+float ArcLengthSegment::parameterAt(float s) const {
+    float total = length();
+    if (s <= 0.0f || total <= 0.0f) {
+        return 0.0f;
+    }
+    if (s >= total) {
+        return 1.0f;
+    }
+    // First table entry past s; the interval [i - 1, i] contains it
+    int i = (int)(std::upper_bound(cumulative, cumulative + resolution + 1, s) - cumulative);
+    i = std::clamp(i, 1, resolution);
+    float s0 = cumulative[i - 1], s1 = cumulative[i];
+    float fraction = s1 > s0 ? (s - s0) / (s1 - s0) : 0.0f;
+    float t0 = 1.0f * (i - 1) / resolution;
+    float t = t0 + fraction / resolution;
+    // Newton on lengthAt(t) - s, staying inside the bracketing interval
+    float v = speed(t);
+    if (v > 0.0f) {
+        float refined = t - (s0 + integrate(t0, t) - s) / v;
+        t = std::clamp(refined, t0, 1.0f * i / resolution);
+    }
+    return t;
+}
+
+void ArcLengthSegment::sampleEven(int count, std::vector<Point2>& out, bool includeStart) const {
+    count = std::max(count, 2);
+    float total = length();
+    if (includeStart) {
+        out.push_back(curve.p0);
+    }
+    for (int i = 1; i < count - 1; i++) {
+        out.push_back(Bezier::evaluate(curve, parameterAt(total * i / (count - 1))));
+    }
+    out.push_back(curve.p3);
+}
+
+// Samples at spacing, 2 * spacing, ... strictly before total - spacing / 2, so none lands right
+// before the end point. Counted rather than accumulated, which would stall once the running
+// sum outgrows the spacing's float precision.
+static size_t interiorSamples(float total, float spacing) {
+    if (!(spacing > 0.0f)) {
+        return 0;
+    }
+    double last = (double)total / spacing - 0.5;
+    return last > 1.0 ? (size_t)std::ceil(last) - 1 : 0;
+}
+
+void ArcLengthSegment::sampleEvery(float spacing, std::vector<Point2>& out, bool includeStart) const {
+    float total = length();
+    if (includeStart) {
+        out.push_back(curve.p0);
+    }
+    size_t count = interiorSamples(total, spacing);
+    for (size_t i = 1; i <= count; i++) {
+        out.push_back(Bezier::evaluate(curve, parameterAt((float)(i * (double)spacing))));
+    }
+    out.push_back(curve.p3);
+}
+
+size_t ArcLengthSegment::sampleEveryCount(float spacing, bool includeStart) const {
+    return (includeStart ? 1 : 0) + interiorSamples(length(), spacing) + 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "bezier.h"
+#include <vector>
+
+// A cubic together with its cumulative arc-length table, so samples can be placed at equal
+// distances along the curve instead of equal steps in t.
+class ArcLengthSegment {
+    public:
+        ArcLengthSegment() = default;
+        // The table has `resolution` intervals of equal t (at most kMaxResolution), each
+        // integrated with 5-point Gauss-Legendre quadrature. It is stored inline, so
+        // constructing and copying never allocates.
+        explicit ArcLengthSegment(const CubicSegment& segment, int resolution = 16);
+
+        static constexpr int kMaxResolution = 64;
+
+        const CubicSegment& segment() const { return curve; }
+        float length() const { return resolution > 0 ? cumulative[resolution] : 0.0f; }
+
+        // Arc length from t = 0 to t.
+        float lengthAt(float t) const;
+        // Inverse lookup: binary search in the table, then one Newton step. O(log resolution).
+        float parameterAt(float s) const;
+
+        // `count` points (count >= 2) at equal arc-length spacing, both end points included.
+        void sampleEven(int count, std::vector<Point2>& out, bool includeStart = true) const;
+        // Points every `spacing` units from the start, plus the end point.
+        void sampleEvery(float spacing, std::vector<Point2>& out, bool includeStart = true) const;
+        // Exact number of points sampleEvery appends.
+        size_t sampleEveryCount(float spacing, bool includeStart = true) const;
+
+    private:
+        float speed(float t) const;
+        float integrate(float t0, float t1) const;
+
+        CubicSegment curve = {};
+        int resolution = 0;
+        float cumulative[kMaxResolution + 1] = {};  // cumulative[i] = length at t = i / resolution
+};
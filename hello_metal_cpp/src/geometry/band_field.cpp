@@ -0,0 +1,131 @@
+#include "band_field.h"
+#include "closest_point.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+static uint64_t tileKey(int32_t x, int32_t y) {
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+// Tiles whose centre lies within `reach` of the piece a-b, reach already including the
+// half diagonal of a tile so no tile touching the band is missed.
+static void markPiece(const Point2& a, const Point2& b, float tileWorld, float reach, std::vector<uint64_t>& keys) {
+    int x0 = (int)std::floor((std::fmin(a.x, b.x) - reach) / tileWorld);
+    int x1 = (int)std::floor((std::fmax(a.x, b.x) + reach) / tileWorld);
+    int y0 = (int)std::floor((std::fmin(a.y, b.y) - reach) / tileWorld);
+    int y1 = (int)std::floor((std::fmax(a.y, b.y) + reach) / tileWorld);
+    const float ex = b.x - a.x, ey = b.y - a.y;
+    const float lengthSq = ex * ex + ey * ey;
+    for (int ty = y0; ty <= y1; ty++) {
+        for (int tx = x0; tx <= x1; tx++) {
+            float cx = (tx + 0.5f) * tileWorld, cy = (ty + 0.5f) * tileWorld;
+            float t = lengthSq > 0.0f ? std::clamp(((cx - a.x) * ex + (cy - a.y) * ey) / lengthSq, 0.0f, 1.0f) : 0.0f;
+            float dx = a.x + ex * t - cx, dy = a.y + ey * t - cy;
+            if (dx * dx + dy * dy <= reach * reach) {
+                keys.push_back(tileKey(tx, ty));
+            }
+        }
+    }
+}
+
+BandDistanceField::BandDistanceField(const CubicSegmentsSoA& segments, const BandFieldOptions& options)
+: cellSize(options.cellSize)
+, bandWidth(options.bandWidth) {
+    const float tileWorld = cellSize * kTileSize;
+    const float tolerance = 0.5f * cellSize;
+    const float reach = bandWidth + tolerance + tileWorld * 0.7072f;
+
+    // Candidate tiles from the flattened segments, collected per chunk and merged
+    std::vector<uint64_t> keys;
+    std::mutex keysMutex;
+    Parallel::forRange(segments.size(), [&](size_t begin, size_t end) {
+        std::vector<Point2> polyline;
+        std::vector<uint64_t> chunkKeys, segmentKeys;
+        for (size_t i = begin; i < end; i++) {
+            polyline.clear();
+            segmentKeys.clear();
+            Bezier::flattenAdaptive(segments.get(i), tolerance, polyline);
+            for (size_t j = 1; j < polyline.size(); j++) {
+                markPiece(polyline[j - 1], polyline[j], tileWorld, reach, segmentKeys);
+            }
+            // Neighbouring pieces mark mostly the same tiles
+            std::sort(segmentKeys.begin(), segmentKeys.end());
+            chunkKeys.insert(chunkKeys.end(), segmentKeys.begin(), std::unique(segmentKeys.begin(), segmentKeys.end()));
+        }
+        std::lock_guard<std::mutex> lock(keysMutex);
+        keys.insert(keys.end(), chunkKeys.begin(), chunkKeys.end());
+    }, 64);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (keys.empty()) {
+        return;
+    }
+
+    // Exact distances for every cell centre of every candidate tile, cut off at the band
+    const size_t cellsPerTile = kTileSize * kTileSize;
+    std::vector<float> qx(keys.size() * cellsPerTile), qy(keys.size() * cellsPerTile);
+    Parallel::forRange(keys.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            int32_t tx = (int32_t)(keys[k] >> 32), ty = (int32_t)(uint32_t)keys[k];
+            for (int cell = 0; cell < (int)cellsPerTile; cell++) {
+                qx[k * cellsPerTile + cell] = (tx * kTileSize + cell % kTileSize + 0.5f) * cellSize;
+                qy[k * cellsPerTile + cell] = (ty * kTileSize + cell / kTileSize + 0.5f) * cellSize;
+            }
+        }
+    }, 64);
+    ClosestPointResults results;
+    ClosestPointEngine(segments).query(qx, qy, results, bandWidth);
+
+    // Keep only tiles with at least one cell inside the band
+    tiles.reserve(keys.size());
+    for (size_t k = 0; k < keys.size(); k++) {
+        const uint32_t* segment = results.segment.data() + k * cellsPerTile;
+        if (std::all_of(segment, segment + cellsPerTile, [](uint32_t s) { return s == SegmentBvh::kInvalid; })) {
+            continue;
+        }
+        tileIndex[keys[k]] = (uint32_t)tiles.size();
+        Tile& tile = tiles.emplace_back();
+        for (size_t cell = 0; cell < cellsPerTile; cell++) {
+            bool inside = segment[cell] != SegmentBvh::kInvalid;
+            tile.segment[cell] = inside ? segment[cell] : kOutside;
+            tile.distance[cell] = inside ? results.distance[k * cellsPerTile + cell] : INFINITY;
+        }
+    }
+    tiles.shrink_to_fit();
+}
+
+const BandDistanceField::Tile* BandDistanceField::find(const Point2& p, int& cell) const {
+    int64_t cx = (int64_t)std::floor(p.x / cellSize), cy = (int64_t)std::floor(p.y / cellSize);
+    if (tiles.empty() || std::abs(cx) >= INT32_MAX / 2 || std::abs(cy) >= INT32_MAX / 2) {
+        return nullptr;
+    }
+    // Floor division so negative coordinates land in the right tile
+    int32_t tx = (int32_t)(cx >= 0 ? cx / kTileSize : (cx - kTileSize + 1) / kTileSize);
+    int32_t ty = (int32_t)(cy >= 0 ? cy / kTileSize : (cy - kTileSize + 1) / kTileSize);
+    auto it = tileIndex.find(tileKey(tx, ty));
+    if (it == tileIndex.end()) {
+        return nullptr;
+    }
+    cell = (int)(cy - (int64_t)ty * kTileSize) * kTileSize + (int)(cx - (int64_t)tx * kTileSize);
+    return &tiles[it->second];
+}
+
+float BandDistanceField::distance(const Point2& p) const {
+    int cell;
+    const Tile* tile = find(p, cell);
+    return tile ? tile->distance[cell] : INFINITY;
+}
+
+uint32_t BandDistanceField::segment(const Point2& p) const {
+    int cell;
+    const Tile* tile = find(p, cell);
+    return tile ? tile->segment[cell] : kOutside;
+}
+
+size_t BandDistanceField::memoryBytes() const {
+    // Tiles plus an estimate of the hash map's nodes and buckets
+    return tiles.capacity() * sizeof(Tile) + tileIndex.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*))
+         + tileIndex.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "bezier.h"
+#include "bezier_batch.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct BandFieldOptions {
+    float cellSize = 0.005f;
+    // Half width of the band; 0.1 matches the default TessellationOptions::normalLength (NDC)
+    float bandWidth = 0.1f;
+};
+
+// Sparse distance field that only exists within bandWidth of the curves. The plane is cut
+// into kTileSize x kTileSize cell tiles; only tiles the band touches are allocated, so memory
+// grows with the total curve length, not with the canvas area. Every stored cell holds the
+// exact distance from its centre to the nearest segment.
+class BandDistanceField {
+    public:
+        static const int kTileSize = 16;
+        static constexpr uint32_t kOutside = UINT32_MAX;
+
+        BandDistanceField() = default;
+        // Tiles are found and filled in parallel; `segments` is only read during construction.
+        explicit BandDistanceField(const CubicSegmentsSoA& segments, const BandFieldOptions& options = BandFieldOptions());
+
+        // Distance stored for the cell containing p, INFINITY outside the band.
+        float distance(const Point2& p) const;
+        // Nearest segment for the cell containing p, kOutside outside the band.
+        uint32_t segment(const Point2& p) const;
+        bool inBand(const Point2& p) const { return segment(p) != kOutside; }
+
+        float getCellSize() const { return cellSize; }
+        float getBandWidth() const { return bandWidth; }
+        size_t tileCount() const { return tiles.size(); }
+        size_t memoryBytes() const;
+
+    private:
+        struct Tile {
+            float distance[kTileSize * kTileSize];
+            uint32_t segment[kTileSize * kTileSize];
+        };
+
+        // Tile holding p and the cell inside it, nullptr outside every allocated tile
+        const Tile* find(const Point2& p, int& cell) const;
+
+        float cellSize = 1.0f;
+        float bandWidth = 0.0f;
+        std::unordered_map<uint64_t, uint32_t> tileIndex;  // packed tile (x, y) -> index into tiles
+        std::vector<Tile> tiles;
+};
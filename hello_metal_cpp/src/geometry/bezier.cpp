@@ -0,0 +1,129 @@
+#include "bezier.h"
+#include "polynomial.h"
+#include <algorithm>
+
+// Subdivision depth 16 means 65536 pieces per segment, far more than any sane tolerance needs.
+static const int kMaxFlattenDepth = 16;
+
+static Point2 lerp(const Point2& a, const Point2& b, float t) {
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+}
+
+void Bezier::split(const CubicSegment& c, float t, CubicSegment& left, CubicSegment& right) {
+    Point2 p01 = lerp(c.p0, c.p1, t);
+    Point2 p12 = lerp(c.p1, c.p2, t);
+    Point2 p23 = lerp(c.p2, c.p3, t);
+    Point2 p012 = lerp(p01, p12, t);
+    Point2 p123 = lerp(p12, p23, t);
+    Point2 mid = lerp(p012, p123, t);
+    left = { c.p0, p01, p012, mid };
+    right = { mid, p123, p23, c.p3 };
+}
+
+Box2 Bezier::bounds(const CubicSegment& c) {
+    Box2 box;
+    box.expand(c.p0);
+    box.expand(c.p3);
+    // Control points inside the end point box: the convex hull is already covered
+    Box2 hull = box;
+    hull.expand(c.p1);
+    hull.expand(c.p2);
+    if (hull.min.x == box.min.x && hull.min.y == box.min.y && hull.max.x == box.max.x && hull.max.y == box.max.y) {
+        return box;
+    }
+    const float v0[2] = { c.p0.x, c.p0.y }, v1[2] = { c.p1.x, c.p1.y };
+    const float v2[2] = { c.p2.x, c.p2.y }, v3[2] = { c.p3.x, c.p3.y };
+    for (int i = 0; i < 2; i++) {
+        float a = -3.0f * v0[i] + 9.0f * v1[i] - 9.0f * v2[i] + 3.0f * v3[i];
+        float b = 6.0f * v0[i] - 12.0f * v1[i] + 6.0f * v2[i];
+        float d = 3.0f * v1[i] - 3.0f * v0[i];
+        float roots[2];
+        int count = Polynomial::solveQuadratic(a, b, d, roots);
+        for (int j = 0; j < count; j++) {
+            if (roots[j] > 0.0f && roots[j] < 1.0f) {
+                box.expand(evaluate(c, roots[j]));
+            }
+        }
+    }
+    return box;
+}
+
+CurvePoint Bezier::closestPoint(const CubicSegment& c, const Point2& p) {
+    const int samples = 16;
+    CurvePoint best;
+    auto consider = [&](float t) {
+        Point2 q = evaluate(c, t);
+        float dx = q.x - p.x, dy = q.y - p.y;
+        float distanceSq = dx * dx + dy * dy;
+        if (distanceSq < best.distanceSq) {
+            best = { t, distanceSq, q };
+        }
+    };
+    for (int i = 0; i <= samples; i++) {
+        consider(1.0f * i / samples);
+    }
+    float t = best.t;
+    for (int iteration = 0; iteration < 8; iteration++) {
+        Point2 q = evaluate(c, t);
+        Point2 d1 = derivative(c, t);
+        Point2 d2 = secondDerivative(c, t);
+        float dx = q.x - p.x, dy = q.y - p.y;
+        float f = dx * d1.x + dy * d1.y;
+        float df = d1.x * d1.x + d1.y * d1.y + dx * d2.x + dy * d2.y;
+        if (df == 0.0f) {
+            break;
+        }
+        float next = std::clamp(t - f / df, 0.0f, 1.0f);
+        if (std::fabs(next - t) < 1e-7f) {
+            break;
+        }
+        t = next;
+    }
+    consider(t);
+    return best;
+}
+
+float Bezier::flatnessSq(const CubicSegment& c) {
+    // Distance of the control points from their positions on an evenly parameterized line,
+    // bounds the deviation of the curve from the chord by 1/4 of its magnitude.
+    float ux = 3.0f * c.p1.x - 2.0f * c.p0.x - c.p3.x;
+    float uy = 3.0f * c.p1.y - 2.0f * c.p0.y - c.p3.y;
+    float vx = 3.0f * c.p2.x - c.p0.x - 2.0f * c.p3.x;
+    float vy = 3.0f * c.p2.y - c.p0.y - 2.0f * c.p3.y;
+    return std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy);
+}
+
+static void flattenRecursive(const CubicSegment& c, float limitSq, int depth, std::vector<Point2>& out) {
+    if (depth >= kMaxFlattenDepth || Bezier::flatnessSq(c) <= limitSq) {
+        out.push_back(c.p3);
+        return;
+    }
+    CubicSegment left, right;
+    Bezier::split(c, 0.5f, left, right);
+    flattenRecursive(left, limitSq, depth + 1, out);
+    flattenRecursive(right, limitSq, depth + 1, out);
+}
+
+void Bezier::flattenAdaptive(const CubicSegment& c, float tolerance, std::vector<Point2>& out, bool includeStart) {
+    if (includeStart) {
+        out.push_back(c.p0);
+    }
+    // flatnessSq <= 16 * tol^2  <=>  max deviation <= tol
+    float limitSq = 16.0f * tolerance * tolerance;
+    flattenRecursive(c, limitSq, 0, out);
+}
+
+// Same recursion as flattenRecursive, counting the pieces instead of emitting them
+static size_t countRecursive(const CubicSegment& c, float limitSq, int depth) {
+    if (depth >= kMaxFlattenDepth || Bezier::flatnessSq(c) <= limitSq) {
+        return 1;
+    }
+    CubicSegment left, right;
+    Bezier::split(c, 0.5f, left, right);
+    return countRecursive(left, limitSq, depth + 1) + countRecursive(right, limitSq, depth + 1);
+}
+
+size_t Bezier::flattenAdaptiveCount(const CubicSegment& c, float tolerance, bool includeStart) {
+    float limitSq = 16.0f * tolerance * tolerance;
+    return (includeStart ? 1 : 0) + countRecursive(c, limitSq, 0);
+}
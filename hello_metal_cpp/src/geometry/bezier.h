@@ -0,0 +1,106 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Plain float geometry shared by the tessellation code. Nothing in src/geometry
+// includes Metal, so these files also build headless.
+struct Point2 {
+    float x;
+    float y;
+};
+
+// Axis-aligned box, empty when min > max.
+struct Box2 {
+    Point2 min = { INFINITY, INFINITY };
+    Point2 max = { -INFINITY, -INFINITY };
+
+    void expand(const Point2& p) {
+        min.x = std::fmin(min.x, p.x); min.y = std::fmin(min.y, p.y);
+        max.x = std::fmax(max.x, p.x); max.y = std::fmax(max.y, p.y);
+    }
+    void expand(const Box2& b) {
+        min.x = std::fmin(min.x, b.min.x); min.y = std::fmin(min.y, b.min.y);
+        max.x = std::fmax(max.x, b.max.x); max.y = std::fmax(max.y, b.max.y);
+    }
+    bool overlaps(const Box2& b) const {
+        return min.x <= b.max.x && b.min.x <= max.x && min.y <= b.max.y && b.min.y <= max.y;
+    }
+    Point2 center() const { return { 0.5f * (min.x + max.x), 0.5f * (min.y + max.y) }; }
+    // Squared distance from p to the box, 0 inside.
+    float distanceSq(const Point2& p) const {
+        float dx = std::fmax(std::fmax(min.x - p.x, 0.0f), p.x - max.x);
+        float dy = std::fmax(std::fmax(min.y - p.y, 0.0f), p.y - max.y);
+        return dx * dx + dy * dy;
+    }
+};
+
+// Result of a closest-point query against one segment.
+struct CurvePoint {
+    float t = 0.0f;
+    float distanceSq = INFINITY;
+    Point2 point = { 0.0f, 0.0f };
+};
+
+// One cubic segment, control points in the order nanosvg stores them in NSVGpath::pts.
+struct CubicSegment {
+    Point2 p0, p1, p2, p3;
+};
+
+namespace Bezier {
+    // Reads 4 consecutive (x,y) pairs, e.g. &path->pts[i * 2].
+    inline CubicSegment fromPoints(const float* p) {
+        return { { p[0], p[1] }, { p[2], p[3] }, { p[4], p[5] }, { p[6], p[7] } };
+    }
+
+    inline Point2 evaluate(const CubicSegment& c, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        float t_dash = 1.0f - t;
+        float t_dash2 = t_dash * t_dash;
+        float t_dash3 = t_dash2 * t_dash;
+        return {
+            t_dash3 * c.p0.x + 3 * t_dash2 * t * c.p1.x + 3 * t_dash * t2 * c.p2.x + t3 * c.p3.x,
+            t_dash3 * c.p0.y + 3 * t_dash2 * t * c.p1.y + 3 * t_dash * t2 * c.p2.y + t3 * c.p3.y
+        };
+    }
+
+    // First derivative (unnormalized tangent).
+    inline Point2 derivative(const CubicSegment& c, float t) {
+        float t_dash = 1.0f - t;
+        return {
+            3 * t_dash * t_dash * (c.p1.x - c.p0.x) + 6 * t_dash * t * (c.p2.x - c.p1.x) + 3 * t * t * (c.p3.x - c.p2.x),
+            3 * t_dash * t_dash * (c.p1.y - c.p0.y) + 6 * t_dash * t * (c.p2.y - c.p1.y) + 3 * t * t * (c.p3.y - c.p2.y)
+        };
+    }
+
+    inline Point2 secondDerivative(const CubicSegment& c, float t) {
+        float t_dash = 1.0f - t;
+        return {
+            6 * t_dash * (c.p2.x - 2 * c.p1.x + c.p0.x) + 6 * t * (c.p3.x - 2 * c.p2.x + c.p1.x),
+            6 * t_dash * (c.p2.y - 2 * c.p1.y + c.p0.y) + 6 * t * (c.p3.y - 2 * c.p2.y + c.p1.y)
+        };
+    }
+
+    // Tight bounds: end points plus the curve extrema where a derivative component is zero,
+    // the same approach as nsvg__curveBounds.
+    Box2 bounds(const CubicSegment& c);
+
+    // Closest point on the segment to p: coarse sampling followed by Newton iterations on
+    // (B(t) - p) . B'(t) = 0, end points included.
+    CurvePoint closestPoint(const CubicSegment& c, const Point2& p);
+
+    // de Casteljau split at t.
+    void split(const CubicSegment& c, float t, CubicSegment& left, CubicSegment& right);
+
+    // Squared flatness measure: the curve never deviates from the chord p0-p3 by more
+    // than sqrt(flatnessSq(c)) / 4.
+    float flatnessSq(const CubicSegment& c);
+
+    // Recursive subdivision until every piece is within `tolerance` of its chord.
+    // Appends the end point of every piece; the start point p0 is appended only if
+    // includeStart is set, so consecutive segments of a path can share vertices.
+    void flattenAdaptive(const CubicSegment& c, float tolerance, std::vector<Point2>& out, bool includeStart = true);
+    // Exact number of points flattenAdaptive appends, without producing them.
+    size_t flattenAdaptiveCount(const CubicSegment& c, float tolerance, bool includeStart = true);
+}
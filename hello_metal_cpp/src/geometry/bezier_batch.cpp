@@ -0,0 +1,236 @@
+#include "bezier_batch.h"
+#include "simd_float.h"
+#include <cassert>
+#include <cmath>
+
+void CubicSegmentsSoA::reserve(size_t n) {
+    for (std::vector<float>* v : { &x0, &y0, &x1, &y1, &x2, &y2, &x3, &y3 }) {
+        v->reserve(n);
+    }
+}
+
+void CubicSegmentsSoA::clear() {
+    for (std::vector<float>* v : { &x0, &y0, &x1, &y1, &x2, &y2, &x3, &y3 }) {
+        v->clear();
+    }
+}
+
+void CubicSegmentsSoA::push(const CubicSegment& c) {
+    x0.push_back(c.p0.x); y0.push_back(c.p0.y);
+    x1.push_back(c.p1.x); y1.push_back(c.p1.y);
+    x2.push_back(c.p2.x); y2.push_back(c.p2.y);
+    x3.push_back(c.p3.x); y3.push_back(c.p3.y);
+}
+
+CubicSegment CubicSegmentsSoA::get(size_t i) const {
+    return { { x0[i], y0[i] }, { x1[i], y1[i] }, { x2[i], y2[i] }, { x3[i], y3[i] } };
+}
+
+BezierBasis::BezierBasis(std::span<const float> ts) : count(ts.size()) {
+    for (std::vector<float>* v : { &b0, &b1, &b2, &b3, &d0, &d1, &d2, &s0, &s1, &side }) {
+        v->resize(count);
+    }
+    for (size_t k = 0; k < count; k++) {
+        float t = ts[k];
+        float t_dash = 1.0f - t;
+        b0[k] = t_dash * t_dash * t_dash;
+        b1[k] = 3 * t_dash * t_dash * t;
+        b2[k] = 3 * t_dash * t * t;
+        b3[k] = t * t * t;
+        d0[k] = 3 * t_dash * t_dash;
+        d1[k] = 6 * t_dash * t;
+        d2[k] = 3 * t * t;
+        s0[k] = 6 * t_dash;
+        s1[k] = 6 * t;
+        side[k] = t < 1.0f ? 1.0f : -1.0f;
+    }
+}
+
+BezierBasis BezierBasis::uniform(int numSamples) {
+    std::vector<float> ts(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        ts[i] = numSamples > 1 ? 1.0f * i / (numSamples - 1) : 0.0f;
+    }
+    return BezierBasis(ts);
+}
+
+const char* Bezier::batchBackend() {
+    return SIMD_FLOAT_BACKEND;
+}
+
+// Scalar evaluation of parameters [begin, end) of one segment; also the SIMD tail.
+static void evaluateScalar(const CubicSegment& c, const BezierBasis& basis, size_t begin, size_t end,
+                           float* x, float* y, float* dx, float* dy) {
+    float ax = c.p1.x - c.p0.x, ay = c.p1.y - c.p0.y;
+    float bx = c.p2.x - c.p1.x, by = c.p2.y - c.p1.y;
+    float cx = c.p3.x - c.p2.x, cy = c.p3.y - c.p2.y;
+    for (size_t k = begin; k < end; k++) {
+        x[k] = basis.b0[k] * c.p0.x + basis.b1[k] * c.p1.x + basis.b2[k] * c.p2.x + basis.b3[k] * c.p3.x;
+        y[k] = basis.b0[k] * c.p0.y + basis.b1[k] * c.p1.y + basis.b2[k] * c.p2.y + basis.b3[k] * c.p3.y;
+        if (dx) {
+            dx[k] = basis.d0[k] * ax + basis.d1[k] * bx + basis.d2[k] * cx;
+            dy[k] = basis.d0[k] * ay + basis.d1[k] * by + basis.d2[k] * cy;
+        }
+    }
+}
+
+void Bezier::evaluateBatch(const CubicSegmentsSoA& segments, const BezierBasis& basis,
+                           std::span<float> x, std::span<float> y,
+                           std::span<float> dx, std::span<float> dy) {
+    const size_t n = basis.count;
+    const size_t total = segments.size() * n;
+    const bool derivatives = !dx.empty();
+    assert(x.size() >= total && y.size() >= total);
+    assert(!derivatives || (dx.size() >= total && dy.size() >= total));
+
+    // Vectorized across parameters: each segment's control points are broadcast once and
+    // the shared basis is streamed, so every store is contiguous.
+    for (size_t s = 0; s < segments.size(); s++) {
+        CubicSegment c = segments.get(s);
+        float* outX = x.data() + s * n;
+        float* outY = y.data() + s * n;
+        float* outDX = derivatives ? dx.data() + s * n : nullptr;
+        float* outDY = derivatives ? dy.data() + s * n : nullptr;
+        const size_t vectorEnd = n - n % kLanes;
+        VecF px0 = vset(c.p0.x), px1 = vset(c.p1.x), px2 = vset(c.p2.x), px3 = vset(c.p3.x);
+        VecF py0 = vset(c.p0.y), py1 = vset(c.p1.y), py2 = vset(c.p2.y), py3 = vset(c.p3.y);
+        VecF ax = vset(c.p1.x - c.p0.x), ay = vset(c.p1.y - c.p0.y);
+        VecF bx = vset(c.p2.x - c.p1.x), by = vset(c.p2.y - c.p1.y);
+        VecF cx = vset(c.p3.x - c.p2.x), cy = vset(c.p3.y - c.p2.y);
+        for (size_t k = 0; k < vectorEnd; k += kLanes) {
+            VecF w0 = vload(&basis.b0[k]), w1 = vload(&basis.b1[k]);
+            VecF w2 = vload(&basis.b2[k]), w3 = vload(&basis.b3[k]);
+            vstore(outX + k, vmadd(w3, px3, vmadd(w2, px2, vmadd(w1, px1, vmul(w0, px0)))));
+            vstore(outY + k, vmadd(w3, py3, vmadd(w2, py2, vmadd(w1, py1, vmul(w0, py0)))));
+            if (derivatives) {
+                VecF e0 = vload(&basis.d0[k]), e1 = vload(&basis.d1[k]), e2 = vload(&basis.d2[k]);
+                vstore(outDX + k, vmadd(e2, cx, vmadd(e1, bx, vmul(e0, ax))));
+                vstore(outDY + k, vmadd(e2, cy, vmadd(e1, by, vmul(e0, ay))));
+            }
+        }
+        evaluateScalar(c, basis, vectorEnd, n, outX, outY, outDX, outDY);
+    }
+}
+
+// A derivative counts as vanished below this fraction of the control polygon's size, squared
+static const float kVanishing = 1e-10f;
+
+// Frames of segment s at every parameter; also the SIMD tail. Same steps as the vector kernel.
+static void framesScalar(const CubicSegmentsSoA& segments, size_t s, const BezierBasis& basis, float offset,
+                         CurveFrames& frames) {
+    CubicSegment c = segments.get(s);
+    float ax = c.p1.x - c.p0.x, ay = c.p1.y - c.p0.y;
+    float bx = c.p2.x - c.p1.x, by = c.p2.y - c.p1.y;
+    float cx = c.p3.x - c.p2.x, cy = c.p3.y - c.p2.y;
+    float ex = bx - ax, ey = by - ay;  // second differences
+    float fx = cx - bx, fy = cy - by;
+    float gx = fx - ex, gy = fy - ey;  // third difference
+    float hx = c.p3.x - c.p0.x, hy = c.p3.y - c.p0.y;
+    float threshold = kVanishing * (ax * ax + ay * ay + bx * bx + by * by + cx * cx + cy * cy);
+    for (size_t k = 0; k < basis.count; k++) {
+        size_t i = frames.index(s, k);
+        float x = basis.b0[k] * c.p0.x + basis.b1[k] * c.p1.x + basis.b2[k] * c.p2.x + basis.b3[k] * c.p3.x;
+        float y = basis.b0[k] * c.p0.y + basis.b1[k] * c.p1.y + basis.b2[k] * c.p2.y + basis.b3[k] * c.p3.y;
+        float dx = basis.d0[k] * ax + basis.d1[k] * bx + basis.d2[k] * cx;
+        float dy = basis.d0[k] * ay + basis.d1[k] * by + basis.d2[k] * cy;
+        float ddx = basis.s0[k] * ex + basis.s1[k] * fx;
+        float ddy = basis.s0[k] * ey + basis.s1[k] * fy;
+        float speed2 = dx * dx + dy * dy;
+        float tx = dx, ty = dy;
+        if (!(threshold < tx * tx + ty * ty)) {
+            tx = basis.side[k] * ddx;
+            ty = basis.side[k] * ddy;
+        }
+        if (!(threshold < tx * tx + ty * ty)) {
+            tx = gx;
+            ty = gy;
+        }
+        if (!(threshold < tx * tx + ty * ty)) {
+            tx = hx;
+            ty = hy;
+        }
+        float length2 = tx * tx + ty * ty;
+        float inverse = length2 > 0.0f ? 1.0f / std::sqrt(length2) : 0.0f;
+        float nx = -ty * inverse, ny = tx * inverse;
+        frames.x[i] = x;
+        frames.y[i] = y;
+        frames.normalX[i] = nx;
+        frames.normalY[i] = ny;
+        frames.curvature[i] = threshold < speed2 ? (dx * ddy - dy * ddx) / (speed2 * std::sqrt(speed2)) : 0.0f;
+        frames.offsetX[i] = x + offset * nx;
+        frames.offsetY[i] = y + offset * ny;
+    }
+}
+
+void Bezier::evaluateFrames(const CubicSegmentsSoA& segments, const BezierBasis& basis, float offset,
+                            CurveFrames& frames) {
+    const size_t count = segments.size();
+    frames.segmentCount = count;
+    frames.sampleCount = basis.count;
+    for (std::vector<float>* v : { &frames.x, &frames.y, &frames.normalX, &frames.normalY, &frames.curvature,
+                                   &frames.offsetX, &frames.offsetY }) {
+        v->resize(count * basis.count);
+    }
+
+    // Vectorized across segments: lanes load consecutive control points straight from the
+    // SoA arrays and the basis weights are broadcast. Parameters go in the outer loop so every
+    // output array is written front to back.
+    const size_t vectorEnd = count - count % kLanes;
+    const VecF zero = vset(0.0f), one = vset(1.0f), offsetV = vset(offset), vanishing = vset(kVanishing);
+    for (size_t k = 0; k < basis.count; k++) {
+        VecF w0 = vset(basis.b0[k]), w1 = vset(basis.b1[k]), w2 = vset(basis.b2[k]), w3 = vset(basis.b3[k]);
+        VecF e0 = vset(basis.d0[k]), e1 = vset(basis.d1[k]), e2 = vset(basis.d2[k]);
+        VecF s0 = vset(basis.s0[k]), s1 = vset(basis.s1[k]), side = vset(basis.side[k]);
+        for (size_t s = 0; s < vectorEnd; s += kLanes) {
+            VecF px0 = vload(&segments.x0[s]), px1 = vload(&segments.x1[s]), px2 = vload(&segments.x2[s]), px3 = vload(&segments.x3[s]);
+            VecF py0 = vload(&segments.y0[s]), py1 = vload(&segments.y1[s]), py2 = vload(&segments.y2[s]), py3 = vload(&segments.y3[s]);
+            VecF ax = vsub(px1, px0), ay = vsub(py1, py0);
+            VecF bx = vsub(px2, px1), by = vsub(py2, py1);
+            VecF cx = vsub(px3, px2), cy = vsub(py3, py2);
+            VecF ex = vsub(bx, ax), ey = vsub(by, ay);
+            VecF fx = vsub(cx, bx), fy = vsub(cy, by);
+            VecF size2 = vmadd(ax, ax, vmadd(ay, ay, vmadd(bx, bx, vmadd(by, by, vmadd(cx, cx, vmul(cy, cy))))));
+            VecF threshold = vmul(vanishing, size2);
+            VecF x = vmadd(w3, px3, vmadd(w2, px2, vmadd(w1, px1, vmul(w0, px0))));
+            VecF y = vmadd(w3, py3, vmadd(w2, py2, vmadd(w1, py1, vmul(w0, py0))));
+            VecF dx = vmadd(e2, cx, vmadd(e1, bx, vmul(e0, ax)));
+            VecF dy = vmadd(e2, cy, vmadd(e1, by, vmul(e0, ay)));
+            VecF ddx = vmadd(s1, fx, vmul(s0, ex));
+            VecF ddy = vmadd(s1, fy, vmul(s0, ey));
+            VecF speed2 = vmadd(dx, dx, vmul(dy, dy));
+
+            // Fall back lane by lane while the candidate tangent has vanished
+            VecMask valid = vless(threshold, speed2);
+            VecF tx = vselect(valid, dx, vmul(side, ddx));
+            VecF ty = vselect(valid, dy, vmul(side, ddy));
+            valid = vless(threshold, vmadd(tx, tx, vmul(ty, ty)));
+            tx = vselect(valid, tx, vsub(fx, ex));
+            ty = vselect(valid, ty, vsub(fy, ey));
+            valid = vless(threshold, vmadd(tx, tx, vmul(ty, ty)));
+            tx = vselect(valid, tx, vsub(px3, px0));
+            ty = vselect(valid, ty, vsub(py3, py0));
+            VecF length2 = vmadd(tx, tx, vmul(ty, ty));
+            VecMask nonzero = vless(zero, length2);
+            VecF inverse = vselect(nonzero, vdiv(one, vsqrt(vselect(nonzero, length2, one))), zero);
+            VecF nx = vmul(vsub(zero, ty), inverse);
+            VecF ny = vmul(tx, inverse);
+
+            VecMask moving = vless(threshold, speed2);
+            VecF cross = vsub(vmul(dx, ddy), vmul(dy, ddx));
+            VecF speed3 = vmul(speed2, vsqrt(speed2));
+            VecF curvature = vselect(moving, vdiv(cross, vselect(moving, speed3, one)), zero);
+
+            size_t i = frames.index(s, k);
+            vstore(&frames.x[i], x);
+            vstore(&frames.y[i], y);
+            vstore(&frames.normalX[i], nx);
+            vstore(&frames.normalY[i], ny);
+            vstore(&frames.curvature[i], curvature);
+            vstore(&frames.offsetX[i], vmadd(offsetV, nx, x));
+            vstore(&frames.offsetY[i], vmadd(offsetV, ny, y));
+        }
+    }
+    for (size_t s = vectorEnd; s < count; s++) {
+        framesScalar(segments, s, basis, offset, frames);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "bezier.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Structure-of-arrays block of cubic segments, one entry per segment.
+struct CubicSegmentsSoA {
+    std::vector<float> x0, y0, x1, y1, x2, y2, x3, y3;
+
+    size_t size() const { return x0.size(); }
+    void reserve(size_t n);
+    void clear();
+    void push(const CubicSegment& c);
+    CubicSegment get(size_t i) const;
+};
+
+// Bernstein weights for a fixed set of parameters, computed once and shared by every
+// segment of a batch.
+struct BezierBasis {
+    size_t count = 0;
+    std::vector<float> b0, b1, b2, b3;  // position weights
+    std::vector<float> d0, d1, d2;      // derivative weights on (p1-p0), (p2-p1), (p3-p2)
+    std::vector<float> s0, s1;          // second derivative weights on (p2-2p1+p0), (p3-2p2+p1)
+    std::vector<float> side;            // +1, or -1 at t = 1 where only the curve before t exists
+
+    explicit BezierBasis(std::span<const float> ts);
+    static BezierBasis uniform(int numSamples);  // t = i / (numSamples - 1)
+};
+
+// Unit normals, signed curvature and offset points of a batch of segments at the parameters
+// of a basis. Vectorized across segments, so sample k of segment s is at k * segmentCount + s
+// of every array.
+struct CurveFrames {
+    size_t segmentCount = 0;
+    size_t sampleCount = 0;
+    std::vector<float> x, y;              // points on the curve
+    std::vector<float> normalX, normalY;  // unit left normals (-tangent.y, tangent.x)
+    std::vector<float> curvature;         // signed, positive when turning left
+    std::vector<float> offsetX, offsetY;  // point + offset * normal
+
+    size_t index(size_t segment, size_t sample) const { return sample * segmentCount + segment; }
+};
+
+namespace Bezier {
+    // Name of the code path compiled in: "avx2", "sse2", "neon" or "scalar".
+    const char* batchBackend();
+
+    // Evaluates every segment at every parameter of `basis`. Results for segment s live at
+    // [s * basis.count, (s + 1) * basis.count) of each output span, which must be at least
+    // segments.size() * basis.count long. Pass empty dx/dy spans to skip derivatives.
+    void evaluateBatch(const CubicSegmentsSoA& segments, const BezierBasis& basis,
+                       std::span<float> x, std::span<float> y,
+                       std::span<float> dx = {}, std::span<float> dy = {});
+
+    // Fills `frames` for every segment at every parameter of `basis`, `offset` along the
+    // normal. Where the derivative vanishes (coincident control points, cusps) the tangent is
+    // the limit direction from the second or third derivative, else the chord; a segment
+    // that is a single point gets zero normals. Curvature is 0 there instead of unbounded.
+    void evaluateFrames(const CubicSegmentsSoA& segments, const BezierBasis& basis, float offset,
+                        CurveFrames& frames);
+}
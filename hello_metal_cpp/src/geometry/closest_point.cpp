@@ -0,0 +1,201 @@
+#include "closest_point.h"
+#include "parallel.h"
+#include "simd_float.h"
+#include <algorithm>
+
+static const int kNewtonIterations = 4;
+
+void ClosestPointResults::resize(size_t n) {
+    segment.resize(n);
+    t.resize(n);
+    distance.resize(n);
+    x.resize(n);
+    y.resize(n);
+}
+
+ClosestPointEngine::ClosestPointEngine(const CubicSegmentsSoA& segments)
+: segments(segments)
+, bvh(segments) {
+}
+
+static uint32_t spreadBits(uint32_t v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+void ClosestPointEngine::query(std::span<const float> qx, std::span<const float> qy, ClosestPointResults& out,
+                               float maxDistance) const {
+    const size_t n = qx.size();
+    out.resize(n);
+    if (n == 0) {
+        return;
+    }
+
+    // Morton order keeps the queries of a packet close together, so they prune the same nodes
+    Box2 extent;
+    for (size_t i = 0; i < n; i++) {
+        extent.expand(Point2{ qx[i], qy[i] });
+    }
+    float w = std::fmax(extent.max.x - extent.min.x, 1e-30f), h = std::fmax(extent.max.y - extent.min.y, 1e-30f);
+    std::vector<uint64_t> keys(n);
+    Parallel::forRange(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            uint32_t mx = (uint32_t)((qx[i] - extent.min.x) / w * 65535.0f);
+            uint32_t my = (uint32_t)((qy[i] - extent.min.y) / h * 65535.0f);
+            keys[i] = ((uint64_t)(spreadBits(mx) | (spreadBits(my) << 1)) << 32) | i;
+        }
+    });
+    std::sort(keys.begin(), keys.end());
+
+    float maxDistanceSq = maxDistance * maxDistance;
+    size_t packets = (n + kPacketSize - 1) / kPacketSize;
+    Parallel::forRange(packets, [&](size_t begin, size_t end) {
+        uint32_t hint = SegmentBvh::kInvalid;
+        for (size_t p = begin; p < end; p++) {
+            float px[kPacketSize], py[kPacketSize], t[kPacketSize], distanceSq[kPacketSize];
+            uint32_t segment[kPacketSize];
+            int lanes = (int)std::min<size_t>(kPacketSize, n - p * kPacketSize);
+            for (int l = 0; l < lanes; l++) {
+                uint32_t q = (uint32_t)keys[p * kPacketSize + l];
+                px[l] = qx[q];
+                py[l] = qy[q];
+            }
+            for (int l = lanes; l < kPacketSize; l++) {
+                px[l] = px[0];  // padding for the SIMD loads, never accepted
+                py[l] = py[0];
+            }
+            queryPacket(px, py, lanes, maxDistanceSq, hint, segment, t, distanceSq);
+            hint = segment[lanes - 1];
+            for (int l = 0; l < lanes; l++) {
+                uint32_t q = (uint32_t)keys[p * kPacketSize + l];
+                out.segment[q] = segment[l];
+                out.t[q] = t[l];
+                out.distance[q] = std::sqrt(distanceSq[l]);
+                Point2 point = segment[l] != SegmentBvh::kInvalid ? Bezier::evaluate(segments.get(segment[l]), t[l]) : Point2{ NAN, NAN };
+                out.x[q] = point.x;
+                out.y[q] = point.y;
+            }
+        }
+    }, 64);
+}
+
+// Closest point of one segment for every lane; lanes where it beats the current best take it.
+// The packet is processed kLanes queries at a time, one query per SIMD lane.
+void ClosestPointEngine::testSegment(uint32_t index, const float* px, const float* py, int lanes,
+                                     uint32_t* segment, float* t, float* distanceSq) const {
+    static_assert(kPacketSize % kLanes == 0, "a packet must be a whole number of SIMD vectors");
+    const CubicSegment c = segments.get(index);
+    const float ax = -c.p0.x + 3 * c.p1.x - 3 * c.p2.x + c.p3.x, ay = -c.p0.y + 3 * c.p1.y - 3 * c.p2.y + c.p3.y;
+    const float bx = 3 * c.p0.x - 6 * c.p1.x + 3 * c.p2.x, by = 3 * c.p0.y - 6 * c.p1.y + 3 * c.p2.y;
+    const float cx = 3 * (c.p1.x - c.p0.x), cy = 3 * (c.p1.y - c.p0.y);
+    const VecF vax = vset(ax), vbx = vset(bx), vcx = vset(cx), vdx = vset(c.p0.x);
+    const VecF vay = vset(ay), vby = vset(by), vcy = vset(cy), vdy = vset(c.p0.y);
+    const VecF zero = vset(0.0f), one = vset(1.0f), step = vset(1.0f / kSamplesPerSegment);
+
+    for (int group = 0; group < lanes; group += (int)kLanes) {
+        const VecF qx = vload(px + group), qy = vload(py + group);
+
+        // Coarse pass over uniform samples; the sample point itself is shared by all lanes
+        VecF bestSq = vset(INFINITY), bestT = zero;
+        for (int s = 0; s <= kSamplesPerSegment; s++) {
+            float u = 1.0f * s / kSamplesPerSegment;
+            VecF dx = vsub(vset(((ax * u + bx) * u + cx) * u + c.p0.x), qx);
+            VecF dy = vsub(vset(((ay * u + by) * u + cy) * u + c.p0.y), qy);
+            VecF d = vmadd(dx, dx, vmul(dy, dy));
+            VecMask closer = vless(d, bestSq);
+            bestSq = vselect(closer, d, bestSq);
+            bestT = vselect(closer, vset(u), bestT);
+        }
+
+        // Newton on the quintic (B(t) - p) . B'(t) = 0, confined to the neighbouring samples
+        const VecF lo = vmax(vsub(bestT, step), zero), hi = vmin(vadd(bestT, step), one);
+        VecF u = bestT;
+        for (int iteration = 0; iteration < kNewtonIterations; iteration++) {
+            VecF ex = vsub(vmadd(vmadd(vmadd(vax, u, vbx), u, vcx), u, vdx), qx);
+            VecF ey = vsub(vmadd(vmadd(vmadd(vay, u, vby), u, vcy), u, vdy), qy);
+            VecF d1x = vmadd(vmadd(vmul(vset(3.0f), vax), u, vmul(vset(2.0f), vbx)), u, vcx);
+            VecF d1y = vmadd(vmadd(vmul(vset(3.0f), vay), u, vmul(vset(2.0f), vby)), u, vcy);
+            VecF d2x = vmadd(vset(6.0f * ax), u, vset(2.0f * bx));
+            VecF d2y = vmadd(vset(6.0f * ay), u, vset(2.0f * by));
+            VecF f = vmadd(ex, d1x, vmul(ey, d1y));
+            VecF df = vmadd(d1x, d1x, vmadd(d1y, d1y, vmadd(ex, d2x, vmul(ey, d2y))));
+            // df <= 0 leaves the lane where it is; the division result is discarded
+            VecF next = vselect(vless(zero, df), vsub(u, vdiv(f, df)), u);
+            u = vmin(vmax(next, lo), hi);
+        }
+        VecF ex = vsub(vmadd(vmadd(vmadd(vax, u, vbx), u, vcx), u, vdx), qx);
+        VecF ey = vsub(vmadd(vmadd(vmadd(vay, u, vby), u, vcy), u, vdy), qy);
+        VecF d = vmadd(ex, ex, vmul(ey, ey));
+        VecMask refined = vless(d, bestSq);
+        bestSq = vselect(refined, d, bestSq);
+        bestT = vselect(refined, u, bestT);
+
+        float groupSq[kLanes], groupT[kLanes];
+        vstore(groupSq, bestSq);
+        vstore(groupT, bestT);
+        for (int l = group; l < std::min(group + (int)kLanes, lanes); l++) {
+            if (groupSq[l - group] < distanceSq[l]) {
+                distanceSq[l] = groupSq[l - group];
+                t[l] = groupT[l - group];
+                segment[l] = index;
+            }
+        }
+    }
+}
+
+void ClosestPointEngine::queryPacket(const float* px, const float* py, int lanes, float maxDistanceSq, uint32_t hint,
+                                     uint32_t* segment, float* t, float* distanceSq) const {
+    for (int l = 0; l < kPacketSize; l++) {
+        segment[l] = SegmentBvh::kInvalid;
+        t[l] = 0.0f;
+        distanceSq[l] = l < lanes ? maxDistanceSq : -1.0f;  // unused lanes never accept
+    }
+    const std::vector<SegmentBvh::Node>& nodes = bvh.getNodes();
+    if (nodes.empty()) {
+        return;
+    }
+    // The previous packet's answer is nearby in Morton order and gives a tight initial bound
+    if (hint != SegmentBvh::kInvalid) {
+        testSegment(hint, px, py, lanes, segment, t, distanceSq);
+    }
+    Point2 centre = { 0.0f, 0.0f };
+    for (int l = 0; l < lanes; l++) {
+        centre.x += px[l] / lanes;
+        centre.y += py[l] / lanes;
+    }
+    uint32_t stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const SegmentBvh::Node& node = nodes[index];
+        bool visit = false;
+        for (int l = 0; l < lanes; l++) {
+            visit |= node.bounds.distanceSq({ px[l], py[l] }) < distanceSq[l];
+        }
+        if (!visit) {
+            continue;
+        }
+        if (node.segment == SegmentBvh::kInvalid) {
+            // Closer child (to the packet centre) on top, so the best distances shrink early
+            uint32_t first = index + 1, second = node.right;
+            if (nodes[second].bounds.distanceSq(centre) < nodes[first].bounds.distanceSq(centre)) {
+                std::swap(first, second);
+            }
+            stack[top++] = second;
+            stack[top++] = first;
+            continue;
+        }
+
+        testSegment(node.segment, px, py, lanes, segment, t, distanceSq);
+    }
+    for (int l = 0; l < lanes; l++) {
+        if (segment[l] == SegmentBvh::kInvalid) {
+            distanceSq[l] = INFINITY;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "bezier_batch.h"
+#include "segment_bvh.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Per query: nearest segment, parameter on it, distance and the nearest point itself.
+struct ClosestPointResults {
+    std::vector<uint32_t> segment;  // SegmentBvh::kInvalid when nothing is within range
+    std::vector<float> t;
+    std::vector<float> distance;
+    std::vector<float> x, y;
+
+    size_t size() const { return segment.size(); }
+    void resize(size_t n);
+};
+
+// Answers closest-point queries against a fixed set of segments (e.g. SvgSegments::curves).
+// Queries are sorted along a Morton curve and processed in packets of kPacketSize, so a
+// packet shares one BVH traversal and its per-segment work runs lane-wise across queries.
+class ClosestPointEngine {
+    public:
+        static const int kPacketSize = 8;
+        static const int kSamplesPerSegment = 32;
+
+        // Keeps a reference to `segments`, which must outlive the engine.
+        explicit ClosestPointEngine(const CubicSegmentsSoA& segments);
+
+        const SegmentBvh& getBvh() const { return bvh; }
+
+        // Results are written in query order. Spread across all cores.
+        void query(std::span<const float> qx, std::span<const float> qy, ClosestPointResults& out,
+                   float maxDistance = INFINITY) const;
+
+    private:
+        void queryPacket(const float* px, const float* py, int lanes, float maxDistanceSq, uint32_t hint,
+                         uint32_t* segment, float* t, float* distanceSq) const;
+        void testSegment(uint32_t index, const float* px, const float* py, int lanes,
+                         uint32_t* segment, float* t, float* distanceSq) const;
+
+        const CubicSegmentsSoA& segments;
+        SegmentBvh bvh;
+};
@@ -0,0 +1,344 @@
+#include "curve_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = { 'S', 'V', 'G', 'C', 'U', 'R', 'V', 'S' };
+static const uint32_t kByteOrderMark = 0x01020304;
+static const size_t kSectionAlign = 64;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceHash;
+    uint64_t fileBytes;
+    uint64_t segmentCount;
+    float width;
+    float height;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct CacheSection {
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+static uint64_t rotl(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static uint64_t load64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t hashRound(uint64_t acc, uint64_t input) {
+    return rotl(acc + input * kPrime2, 31) * kPrime1;
+}
+
+static size_t alignUp(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+// Maps a whole file read-only. Returns nullptr for missing, empty or unmappable files.
+static const std::byte* mapFile(const char* path, size_t& bytes) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        bytes = (size_t)st.st_size;
+        mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    return mapping == MAP_FAILED ? nullptr : static_cast<const std::byte*>(mapping);
+}
+
+uint64_t CurveCache::hashBytes(const void* data, size_t size) {
+    // Four independent accumulators over 32-byte stripes, then a mix of the tail
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t acc[4] = { kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1 };
+        for (; p + 32 <= end; p += 32) {
+            for (int lane = 0; lane < 4; lane++) {
+                acc[lane] = hashRound(acc[lane], load64(p + lane * 8));
+            }
+        }
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (uint64_t a : acc) {
+            h = (h ^ hashRound(0, a)) * kPrime1 + kPrime3;
+        }
+    } else {
+        h = kPrime3;
+    }
+    h += size;
+    for (; p + 8 <= end; p += 8) {
+        h = rotl(h ^ hashRound(0, load64(p)), 27) * kPrime1 + kPrime3;
+    }
+    for (; p < end; p++) {
+        h = rotl(h ^ (*p * kPrime3), 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    return h ^ (h >> 32);
+}
+
+bool CurveCache::hashFile(const char* path, uint64_t& hash) {
+    size_t bytes = 0;
+    const std::byte* data = mapFile(path, bytes);
+    if (!data) {
+        // Empty files cannot be mapped but still hash
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != 0) {
+            return false;
+        }
+        hash = hashBytes(nullptr, 0);
+        return true;
+    }
+    madvise(const_cast<std::byte*>(data), bytes, MADV_SEQUENTIAL);
+    hash = hashBytes(data, bytes);
+    munmap(const_cast<std::byte*>(data), bytes);
+    return true;
+}
+
+std::string CurveCache::defaultPath(const char* svgPath) {
+    return std::string(svgPath) + ".curves";
+}
+
+bool CurveCache::write(const char* cachePath, uint64_t sourceHash, const SvgSegments& segments,
+                       std::span<const Blob> blobs) {
+    const CubicSegmentsSoA& c = segments.curves;
+    const size_t n = segments.size();
+    const std::vector<float>* coordinates[] = { &c.x0, &c.y0, &c.x1, &c.y1, &c.x2, &c.y2, &c.x3, &c.y3 };
+    if (segments.shapeIds.size() != n || segments.pathIds.size() != n) {
+        return false;
+    }
+
+    // Lay out every section after the header and section table
+    std::vector<std::pair<CacheSection, const void*>> sections;
+    for (uint32_t tag = kX0; tag <= kY3; tag++) {
+        sections.push_back({ { tag, 0, 0, n * sizeof(float) }, coordinates[tag]->data() });
+    }
+    sections.push_back({ { kShapeIds, 0, 0, n * sizeof(int) }, segments.shapeIds.data() });
+    sections.push_back({ { kPathIds, 0, 0, n * sizeof(int) }, segments.pathIds.data() });
+    for (const Blob& blob : blobs) {
+        if (blob.tag < kFirstBlobTag) {
+            return false;
+        }
+        sections.push_back({ { blob.tag, 0, 0, blob.bytes.size() }, blob.bytes.data() });
+    }
+    size_t offset = alignUp(sizeof(CacheHeader) + sections.size() * sizeof(CacheSection), kSectionAlign);
+    for (auto& [section, source] : sections) {
+        section.offset = offset;
+        offset = alignUp(offset + section.bytes, kSectionAlign);
+    }
+
+    CacheHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceHash = sourceHash;
+    header.fileBytes = offset;
+    header.segmentCount = n;
+    header.width = segments.width;
+    header.height = segments.height;
+    header.sectionCount = (uint32_t)sections.size();
+
+    std::string temporary = std::string(cachePath) + ".tmp" + std::to_string(getpid());
+    FILE* fp = fopen(temporary.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    static const char zeros[kSectionAlign] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (const auto& [section, source] : sections) {
+        ok = ok && fwrite(&section, sizeof(section), 1, fp) == 1;
+    }
+    size_t written = sizeof(header) + sections.size() * sizeof(CacheSection);
+    for (const auto& [section, source] : sections) {
+        ok = ok && fwrite(zeros, 1, section.offset - written, fp) == section.offset - written;
+        ok = ok && (section.bytes == 0 || fwrite(source, 1, section.bytes, fp) == section.bytes);
+        written = section.offset + section.bytes;
+    }
+    ok = ok && fwrite(zeros, 1, offset - written, fp) == offset - written;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), cachePath) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CurveCache::update(const char* cachePath, uint64_t sourceHash, const SvgSegments& segments,
+                        std::span<const Blob> blobs) {
+    // The old file stays mapped while the new one is renamed over it
+    CurveCacheFile existing;
+    std::vector<Blob> merged(blobs.begin(), blobs.end());
+    if (existing.open(cachePath, sourceHash)) {
+        for (const Blob& kept : existing.blobs()) {
+            if (std::none_of(blobs.begin(), blobs.end(), [&](const Blob& b) { return b.tag == kept.tag; })) {
+                merged.push_back(kept);
+            }
+        }
+    }
+    return write(cachePath, sourceHash, segments, merged);
+}
+
+CurveCacheFile::~CurveCacheFile() {
+    close();
+}
+
+CurveCacheFile::CurveCacheFile(CurveCacheFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+CurveCacheFile& CurveCacheFile::operator=(CurveCacheFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(data, other.data);
+        std::swap(mappedBytes, other.mappedBytes);
+        std::swap(segmentCount, other.segmentCount);
+        std::swap(imageWidth, other.imageWidth);
+        std::swap(imageHeight, other.imageHeight);
+    }
+    return *this;
+}
+
+void CurveCacheFile::close() {
+    if (data) {
+        munmap(const_cast<std::byte*>(data), mappedBytes);
+    }
+    data = nullptr;
+    mappedBytes = 0;
+    segmentCount = 0;
+    imageWidth = imageHeight = 0.0f;
+}
+
+bool CurveCacheFile::open(const char* cachePath, uint64_t sourceHash) {
+    close();
+    size_t bytes = 0;
+    const std::byte* mapping = mapFile(cachePath, bytes);
+    if (!mapping) {
+        return false;
+    }
+
+    // Everything is checked before any span is handed out
+    CacheHeader header;
+    bool valid = bytes >= sizeof(header);
+    if (valid) {
+        memcpy(&header, mapping, sizeof(header));
+        valid = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == CurveCache::kVersion
+             && header.byteOrder == kByteOrderMark && header.sourceHash == sourceHash && header.fileBytes == bytes
+             && header.sectionCount <= (bytes - sizeof(header)) / sizeof(CacheSection)
+             && header.segmentCount <= bytes / sizeof(float);
+    }
+    const CacheSection* sections = reinterpret_cast<const CacheSection*>(mapping + sizeof(CacheHeader));
+    for (uint32_t i = 0; valid && i < header.sectionCount; i++) {
+        const CacheSection& s = sections[i];
+        valid = s.offset % sizeof(float) == 0 && s.offset <= bytes && s.bytes <= bytes - s.offset;
+        if (s.tag < CurveCache::kFirstBlobTag) {
+            valid = valid && s.bytes == header.segmentCount * sizeof(float);
+        }
+    }
+    if (!valid) {
+        munmap(const_cast<std::byte*>(mapping), bytes);
+        return false;
+    }
+    data = mapping;
+    mappedBytes = bytes;
+    segmentCount = header.segmentCount;
+    imageWidth = header.width;
+    imageHeight = header.height;
+    // Every built-in section must be present
+    for (uint32_t tag = CurveCache::kX0; tag <= CurveCache::kPathIds; tag++) {
+        if (segmentCount > 0 && section(tag).empty()) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::span<const std::byte> CurveCacheFile::section(uint32_t tag) const {
+    if (!data) {
+        return {};
+    }
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    const CacheSection* sections = reinterpret_cast<const CacheSection*>(data + sizeof(CacheHeader));
+    for (uint32_t i = 0; i < header.sectionCount; i++) {
+        if (sections[i].tag == tag) {
+            return { data + sections[i].offset, (size_t)sections[i].bytes };
+        }
+    }
+    return {};
+}
+
+std::span<const float> CurveCacheFile::coordinates(CurveCache::Tag tag) const {
+    std::span<const std::byte> bytes = tag <= CurveCache::kY3 ? section(tag) : std::span<const std::byte>();
+    return { reinterpret_cast<const float*>(bytes.data()), bytes.size() / sizeof(float) };
+}
+
+std::span<const int> CurveCacheFile::shapeIds() const {
+    std::span<const std::byte> bytes = section(CurveCache::kShapeIds);
+    return { reinterpret_cast<const int*>(bytes.data()), bytes.size() / sizeof(int) };
+}
+
+std::span<const int> CurveCacheFile::pathIds() const {
+    std::span<const std::byte> bytes = section(CurveCache::kPathIds);
+    return { reinterpret_cast<const int*>(bytes.data()), bytes.size() / sizeof(int) };
+}
+
+std::span<const std::byte> CurveCacheFile::blob(uint32_t tag) const {
+    return tag >= CurveCache::kFirstBlobTag ? section(tag) : std::span<const std::byte>();
+}
+
+std::vector<CurveCache::Blob> CurveCacheFile::blobs() const {
+    std::vector<CurveCache::Blob> result;
+    if (!data) {
+        return result;
+    }
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    const CacheSection* sections = reinterpret_cast<const CacheSection*>(data + sizeof(CacheHeader));
+    for (uint32_t i = 0; i < header.sectionCount; i++) {
+        if (sections[i].tag >= CurveCache::kFirstBlobTag) {
+            result.push_back({ sections[i].tag, { data + sections[i].offset, (size_t)sections[i].bytes } });
+        }
+    }
+    return result;
+}
+
+SvgSegments CurveCacheFile::toSegments() const {
+    SvgSegments result;
+    CubicSegmentsSoA& c = result.curves;
+    std::vector<float>* coordinateArrays[] = { &c.x0, &c.y0, &c.x1, &c.y1, &c.x2, &c.y2, &c.x3, &c.y3 };
+    for (uint32_t tag = CurveCache::kX0; tag <= CurveCache::kY3; tag++) {
+        std::span<const float> values = coordinates((CurveCache::Tag)tag);
+        coordinateArrays[tag]->assign(values.begin(), values.end());
+    }
+    result.shapeIds.assign(shapeIds().begin(), shapeIds().end());
+    result.pathIds.assign(pathIds().begin(), pathIds().end());
+    result.width = imageWidth;
+    result.height = imageHeight;
+    return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "svg_segments.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary cache of the cubic segments parsed from an SVG, so later launches map a file instead
+// of parsing XML. Layout (native byte order, checked on open):
+//   Header | Section[sectionCount] | section data, each 64-byte aligned
+// Sections are the eight SoA coordinate arrays, the shape and path ids, and any extra blobs the
+// caller adds (e.g. tessellated vertices). The header carries a hash of the source file's bytes;
+// a cache whose hash or version does not match is ignored.
+namespace CurveCache {
+    static constexpr uint32_t kVersion = 1;
+
+    // Section tags. Blob tags of callers must not collide with these.
+    enum Tag : uint32_t {
+        kX0 = 0, kY0, kX1, kY1, kX2, kY2, kX3, kY3,
+        kShapeIds, kPathIds,
+        kFirstBlobTag = 0x100,
+    };
+
+    struct Blob {
+        uint32_t tag;
+        std::span<const std::byte> bytes;
+    };
+
+    // 64-bit content hash, several GB/s; not cryptographic.
+    uint64_t hashBytes(const void* data, size_t size);
+    // Hashes a whole file through a read-only mapping. False if it cannot be read.
+    bool hashFile(const char* path, uint64_t& hash);
+
+    // Conventional cache location for an SVG: next to it, with ".curves" appended.
+    std::string defaultPath(const char* svgPath);
+
+    // Writes to a temporary file and renames it over `cachePath`, so readers never see a
+    // partial cache. False on any I/O error.
+    bool write(const char* cachePath, uint64_t sourceHash, const SvgSegments& segments,
+               std::span<const Blob> blobs = {});
+    // write, keeping every blob of a valid cache already at `cachePath` whose tag is not among
+    // `blobs`, so one kind of mesh can be replaced without dropping the others.
+    bool update(const char* cachePath, uint64_t sourceHash, const SvgSegments& segments,
+                std::span<const Blob> blobs);
+}
+
+// Read-only mapping of a cache file. Spans point straight into the mapping and stay valid
+// while the object lives.
+class CurveCacheFile {
+    public:
+        CurveCacheFile() = default;
+        ~CurveCacheFile();
+        CurveCacheFile(CurveCacheFile&& other) noexcept;
+        CurveCacheFile& operator=(CurveCacheFile&& other) noexcept;
+        CurveCacheFile(const CurveCacheFile&) = delete;
+        CurveCacheFile& operator=(const CurveCacheFile&) = delete;
+
+        // False if the file is missing, truncated, from another version or byte order, or was
+        // built from a source whose hash differs from `sourceHash`.
+        bool open(const char* cachePath, uint64_t sourceHash);
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        size_t size() const { return segmentCount; }
+        float width() const { return imageWidth; }
+        float height() const { return imageHeight; }
+        // Coordinate array by tag, kX0 .. kY3.
+        std::span<const float> coordinates(CurveCache::Tag tag) const;
+        std::span<const int> shapeIds() const;
+        std::span<const int> pathIds() const;
+        // Extra blob by tag, empty if the cache has none.
+        std::span<const std::byte> blob(uint32_t tag) const;
+        // Every extra blob, in file order.
+        std::vector<CurveCache::Blob> blobs() const;
+
+        // Copies everything into an SvgSegments, identical to the one that was written.
+        SvgSegments toSegments() const;
+
+    private:
+        std::span<const std::byte> section(uint32_t tag) const;
+
+        const std::byte* data = nullptr;
+        size_t mappedBytes = 0;
+        size_t segmentCount = 0;
+        float imageWidth = 0.0f;
+        float imageHeight = 0.0f;
+};
@@ -0,0 +1,317 @@
+#include "fill.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// Crossings closer than this to the top of a slab are treated as lying on it
+static const double kMinSlabHeight = 1e-12;
+
+// Non-horizontal edge of a shape's outline, top at y0. The sweep runs in double so slabs
+// between nearby crossings keep their order.
+struct FillEdge {
+    double x0, y0, y1;
+    double slope;  // dx / dy
+    int winding;   // +1 going up, -1 going down
+    uint32_t top, bottom;  // end points in the shape's point list
+
+    double xAt(double y) const { return x0 + (y - y0) * slope; }
+};
+
+// Region between a left and a right edge, from yTop down to where its span changes
+struct Trapezoid {
+    uint32_t left, right;
+    uint32_t topLeft, topRight;  // vertices
+    double yTop;
+};
+
+// One shape's triangles, vertices local to the shape
+struct ShapeFill {
+    std::vector<Point2> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Cuts the closed polylines of one shape (contour c is points[starts[c]] .. points[starts[c + 1]])
+// into trapezoids: a sweep stops at every vertex and crossing, the edges between two stops keep
+// their order, and the spans inside the fill between them are trapezoids. A span bounded by the
+// same two edges as in the previous slab extends the open trapezoid instead of starting one.
+static void fillShape(const std::vector<Point2>& points, const std::vector<size_t>& starts, FillRule rule, ShapeFill& out) {
+    std::vector<FillEdge> edges;
+    for (size_t c = 0; c + 1 < starts.size(); c++) {
+        for (size_t i = starts[c]; i < starts[c + 1]; i++) {
+            uint32_t a = (uint32_t)i;
+            uint32_t b = (uint32_t)(i + 1 < starts[c + 1] ? i + 1 : starts[c]);
+            if (points[a].y == points[b].y) {
+                continue;  // horizontal edges bound no span
+            }
+            // Sweep top to bottom in y-up NDC: y0 is the larger y
+            bool down = points[b].y < points[a].y;
+            Point2 top = points[down ? a : b], bottom = points[down ? b : a];
+            edges.push_back({ top.x, -(double)top.y, -(double)bottom.y, ((double)bottom.x - top.x) / ((double)top.y - bottom.y),
+                              down ? -1 : 1, down ? a : b, down ? b : a });
+        }
+    }
+    if (edges.empty()) {
+        return;
+    }
+    auto inside = [rule](int winding) {
+        return rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+    };
+
+    // Stops: every end point; crossings are found slab by slab
+    std::vector<uint32_t> order(edges.size());
+    std::vector<double> stops;
+    stops.reserve(2 * edges.size());
+    for (uint32_t e = 0; e < edges.size(); e++) {
+        order[e] = e;
+        stops.push_back(edges[e].y0);
+        stops.push_back(edges[e].y1);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return edges[a].y0 < edges[b].y0; });
+    std::sort(stops.begin(), stops.end());
+    stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+
+    // Trapezoids meeting at an end point share its vertex, and so do trapezoids meeting on an
+    // edge at the same y
+    std::vector<uint32_t> pointVertices(points.size(), UINT32_MAX);
+    std::vector<double> cachedY(edges.size(), NAN);
+    std::vector<uint32_t> cachedVertex(edges.size(), 0);
+    auto vertexOn = [&](uint32_t e, double y) {
+        const FillEdge& edge = edges[e];
+        if (y == edge.y0 || y == edge.y1) {
+            uint32_t point = y == edge.y0 ? edge.top : edge.bottom;
+            if (pointVertices[point] == UINT32_MAX) {
+                pointVertices[point] = (uint32_t)out.vertices.size();
+                out.vertices.push_back(points[point]);
+            }
+            return pointVertices[point];
+        }
+        if (cachedY[e] != y) {
+            cachedY[e] = y;
+            cachedVertex[e] = (uint32_t)out.vertices.size();
+            out.vertices.push_back({ (float)edges[e].xAt(y), (float)-y });
+        }
+        return cachedVertex[e];
+    };
+    auto close = [&](const Trapezoid& t, double y) {
+        const FillEdge& left = edges[t.left];
+        const FillEdge& right = edges[t.right];
+        uint32_t bottomLeft = vertexOn(t.left, y);
+        uint32_t bottomRight = vertexOn(t.right, y);
+        // Spans that start or end in a point become a single triangle
+        if (right.xAt(y) > left.xAt(y)) {
+            out.indices.insert(out.indices.end(), { t.topLeft, bottomLeft, bottomRight });
+        }
+        if (right.xAt(t.yTop) > left.xAt(t.yTop)) {
+            out.indices.insert(out.indices.end(), { t.topLeft, bottomRight, t.topRight });
+        }
+    };
+
+    std::vector<uint32_t> active;
+    std::vector<double> keys;
+    std::vector<Trapezoid> open, stillOpen;
+    std::vector<int32_t> openByLeft(edges.size(), -1);  // open trapezoid per left edge
+    std::vector<std::pair<uint32_t, uint32_t>> spans;
+    size_t nextEdge = 0, nextStop = 0;
+    double y = stops[0];
+    while (true) {
+        // Edges ending here leave, edges starting here join
+        active.erase(std::remove_if(active.begin(), active.end(), [&](uint32_t e) { return edges[e].y1 <= y; }), active.end());
+        while (nextEdge < order.size() && edges[order[nextEdge]].y0 <= y) {
+            active.push_back(order[nextEdge++]);
+        }
+        while (nextStop < stops.size() && stops[nextStop] <= y) {
+            nextStop++;
+        }
+        if (nextStop == stops.size()) {
+            for (const Trapezoid& t : open) {
+                close(t, y);
+            }
+            break;
+        }
+
+        // Slab [y, yEnd]: shortened to the first crossing of neighbors, so no edges cross inside
+        double yEnd = stops[nextStop];
+        for (int iteration = 0; iteration < 8; iteration++) {
+            double middle = 0.5 * (y + yEnd);
+            keys.resize(active.size());
+            // Insertion sort by x in the middle of the slab; the order rarely changes
+            for (size_t i = 0; i < active.size(); i++) {
+                uint32_t e = active[i];
+                double key = edges[e].xAt(middle);
+                size_t j = i;
+                for (; j > 0 && keys[j - 1] > key; j--) {
+                    keys[j] = keys[j - 1];
+                    active[j] = active[j - 1];
+                }
+                keys[j] = key;
+                active[j] = e;
+            }
+            double crossing = yEnd;
+            for (size_t i = 0; i + 1 < active.size(); i++) {
+                const FillEdge& a = edges[active[i]];
+                const FillEdge& b = edges[active[i + 1]];
+                double gapTop = b.xAt(y) - a.xAt(y);
+                double gapBottom = b.xAt(yEnd) - a.xAt(yEnd);
+                if ((gapTop < 0.0) != (gapBottom < 0.0)) {
+                    double at = y + (yEnd - y) * gapTop / (gapTop - gapBottom);
+                    if (at > y + kMinSlabHeight && at < crossing) {
+                        crossing = at;
+                    }
+                }
+            }
+            if (crossing >= yEnd) {
+                break;
+            }
+            yEnd = crossing;
+        }
+
+        // Spans inside the fill
+        spans.clear();
+        int winding = 0;
+        uint32_t left = 0;
+        for (uint32_t e : active) {
+            bool wasInside = inside(winding);
+            winding += edges[e].winding;
+            if (!wasInside && inside(winding)) {
+                left = e;
+            } else if (wasInside && !inside(winding)) {
+                spans.push_back({ left, e });
+            }
+        }
+
+        // Trapezoids whose span goes on stay open; the others close here and new spans open
+        stillOpen.clear();
+        for (auto& [l, r] : spans) {
+            int32_t t = openByLeft[l];
+            if (t >= 0 && open[t].right == r) {
+                stillOpen.push_back(open[t]);
+                open[t].right = UINT32_MAX;  // taken
+                r = UINT32_MAX;
+            }
+        }
+        for (const Trapezoid& t : open) {
+            if (t.right != UINT32_MAX) {
+                close(t, y);
+            }
+            openByLeft[t.left] = -1;
+        }
+        for (auto [l, r] : spans) {
+            if (r != UINT32_MAX) {
+                stillOpen.push_back({ l, r, vertexOn(l, y), vertexOn(r, y), y });
+            }
+        }
+        open.swap(stillOpen);
+        for (size_t i = 0; i < open.size(); i++) {
+            openByLeft[open[i].left] = (int32_t)i;
+        }
+        y = yEnd;
+    }
+}
+
+// Per shape buffers, reused by every path of the shape
+struct FillScratch {
+    std::vector<Point2> points;
+    std::vector<size_t> starts;
+};
+
+FillMesh FillMesh::build(const SvgSegments& svg, const SvgStyles& styles, const TessellationOptions& options) {
+    FillMesh mesh;
+    mesh.key.options = options;
+    const size_t segmentCount = svg.size();
+    float div = std::max(svg.width, svg.height);
+    float tolerance = 2.0f * options.tolerancePixels / options.viewportPixels;
+
+    // Segments of a shape are consecutive
+    std::vector<size_t> shapeStarts;
+    for (size_t i = 0; i < segmentCount; i++) {
+        if (i == 0 || svg.shapeIds[i] != svg.shapeIds[i - 1]) {
+            shapeStarts.push_back(i);
+        }
+    }
+    const size_t shapeCount = shapeStarts.size();
+    shapeStarts.push_back(segmentCount);
+
+    auto styleOf = [&](size_t shape) -> const FillStyle* {
+        size_t id = (size_t)svg.shapeIds[shapeStarts[shape]];
+        return id < styles.fills.size() && styles.fills[id].filled ? &styles.fills[id] : nullptr;
+    };
+
+    // Shapes differ wildly in size, so they go to the work-stealing pool one by one
+    std::vector<ShapeFill> fills(shapeCount);
+    Parallel::forEach(shapeCount, [&](size_t shape) {
+        const FillStyle* style = styleOf(shape);
+        if (!style) {
+            return;
+        }
+        FillScratch scratch;
+        for (size_t begin = shapeStarts[shape]; begin < shapeStarts[shape + 1];) {
+            size_t end = begin + 1;
+            while (end < shapeStarts[shape + 1] && svg.pathIds[end] == svg.pathIds[begin]) {
+                end++;
+            }
+            // Every path is filled as if closed; the closing edge is implied
+            size_t start = scratch.points.size();
+            svg.flattenPath(begin, end, div, tolerance, scratch.points);
+            if (scratch.points.size() - start > 1 && scratch.points.back().x == scratch.points[start].x
+                && scratch.points.back().y == scratch.points[start].y) {
+                scratch.points.pop_back();
+            }
+            scratch.starts.push_back(start);
+            begin = end;
+        }
+        scratch.starts.push_back(scratch.points.size());
+        fillShape(scratch.points, scratch.starts, style->rule, fills[shape]);
+    });
+
+    // Prefix sums, then every shape copies itself into place in parallel
+    std::vector<size_t> firstVertices(shapeCount, 0);
+    size_t vertexCount = 0, indexCount = 0;
+    mesh.ranges.resize(shapeCount);
+    for (size_t shape = 0; shape < shapeCount; shape++) {
+        MeshRange& range = mesh.ranges[shape];
+        range.firstIndex = (uint32_t)indexCount;
+        range.indexCount = (uint32_t)fills[shape].indices.size();
+        range.shapeId = svg.shapeIds[shapeStarts[shape]];
+        range.pathId = -1;
+        firstVertices[shape] = vertexCount;
+        vertexCount += fills[shape].vertices.size();
+        indexCount += fills[shape].indices.size();
+    }
+    mesh.vertices.resize(vertexCount);
+    auto write = [&](auto* indices) {
+        using Index = std::remove_pointer_t<decltype(indices)>;
+        Parallel::forRange(shapeCount, [&](size_t begin, size_t end) {
+            for (size_t shape = begin; shape < end; shape++) {
+                const ShapeFill& fill = fills[shape];
+                if (fill.indices.empty()) {
+                    continue;
+                }
+                const float* color = styleOf(shape)->color;
+                MeshRange& range = mesh.ranges[shape];
+                MeshVertex* out = &mesh.vertices[firstVertices[shape]];
+                for (const Point2& p : fill.vertices) {
+                    out->pos[0] = p.x;
+                    out->pos[1] = p.y;
+                    out->color[0] = color[0];
+                    out->color[1] = color[1];
+                    out->color[2] = color[2];
+                    out++;
+                    range.bounds.expand(p);
+                }
+                Index* outIndex = indices + range.firstIndex;
+                for (uint32_t index : fill.indices) {
+                    *outIndex++ = (Index)(firstVertices[shape] + index);
+                }
+            }
+        }, 64);
+    };
+    if (mesh.indexType() == MeshIndexType::UInt16) {
+        mesh.indices16.resize(indexCount);
+        write(mesh.indices16.data());
+    } else {
+        mesh.indices32.resize(indexCount);
+        write(mesh.indices32.data());
+    }
+    return mesh;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "svg_mesh.h"
+#include "svg_styles.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Identifies a fill mesh in the curve cache. Bump version whenever FillMesh::build's output
+// changes for the same segments, styles and options.
+struct FillCacheKey {
+    uint32_t version = 2;
+    uint32_t vertexSize = sizeof(MeshVertex);
+    TessellationOptions options;
+};
+
+// Filled interiors as an indexed triangle list in the fill color, same vertex layout as
+// SvgMesh. Each shape's paths are flattened adaptively, closed, and cut into trapezoids by a
+// sweep over all their edges, so holes, overlaps and self-intersections follow the shape's
+// fill rule without any bridging.
+// Ranges are one per shape, pathId -1; unfilled shapes have no indices.
+// cacheBlobs() are the blobs to pass to CurveCache::update, or as SvgMesh::writeCache's
+// extraBlobs.
+struct FillMesh : CachedMesh<FillCacheKey, kFillMeshTag> {
+    // Segments in pixels, as parsed; `styles` from the same image. Shapes are tessellated in
+    // parallel, each in one sweep that stops at every vertex and crossing.
+    static FillMesh build(const SvgSegments& svg, const SvgStyles& styles,
+                          const TessellationOptions& options = TessellationOptions());
+};
@@ -0,0 +1,58 @@
+#include "forward_difference.h"
+#include <algorithm>
+
+ForwardDifferenceStepper::ForwardDifferenceStepper(const CubicSegment& segment, int numSteps, int reanchorInterval)
+: steps(numSteps > 0 ? numSteps : 1)
+, interval(reanchorInterval > 0 ? reanchorInterval : steps)
+, current(0)
+, untilAnchor(0) {
+    const CubicSegment& s = segment;
+    a = { -s.p0.x + 3 * s.p1.x - 3 * s.p2.x + s.p3.x, -s.p0.y + 3 * s.p1.y - 3 * s.p2.y + s.p3.y };
+    b = { 3 * s.p0.x - 6 * s.p1.x + 3 * s.p2.x, 3 * s.p0.y - 6 * s.p1.y + 3 * s.p2.y };
+    c = { 3 * (s.p1.x - s.p0.x), 3 * (s.p1.y - s.p0.y) };
+    d = s.p0;
+    anchor(0);
+}
+
+void ForwardDifferenceStepper::anchor(int atStep) {
+    // Exact point and differences at t, evaluated in double so re-anchoring removes the drift
+    // instead of adding its own.
+    double t = (double)atStep / steps;
+    double hd = 1.0 / steps;
+    double h2 = hd * hd, h3 = h2 * hd;
+    auto at = [&](float A, float B, float C, float D, float& p, float& d1, float& d2, float& d3) {
+        p = (float)(((A * t + B) * t + C) * t + D);
+        d1 = (float)(A * (3 * t * t * hd + 3 * t * h2 + h3) + B * (2 * t * hd + h2) + C * hd);
+        d2 = (float)(A * (6 * t * h2 + 6 * h3) + B * 2 * h2);
+        d3 = (float)(A * 6 * h3);
+    };
+    at(a.x, b.x, c.x, d.x, point.x, delta1.x, delta2.x, delta3.x);
+    at(a.y, b.y, c.y, d.y, point.y, delta1.y, delta2.y, delta3.y);
+    untilAnchor = std::min(interval, steps - atStep);
+}
+
+void ForwardDifferenceStepper::fill(Point2* out) {
+    for (int blockStart = 0; blockStart < steps; blockStart += interval) {
+        anchor(blockStart);
+        float px = point.x, py = point.y;
+        float d1x = delta1.x, d1y = delta1.y;
+        float d2x = delta2.x, d2y = delta2.y;
+        const float d3x = delta3.x, d3y = delta3.y;
+        for (int i = 0; i < untilAnchor; i++) {
+            out[blockStart + i] = { px, py };
+            px += d1x; py += d1y;
+            d1x += d2x; d1y += d2y;
+            d2x += d3x; d2y += d3y;
+        }
+    }
+    anchor(steps);
+    out[steps] = point;
+    current = steps + 1;
+}
+
+void Bezier::sampleUniform(const CubicSegment& segment, int numLines, std::vector<Point2>& out, int reanchorInterval) {
+    ForwardDifferenceStepper stepper(segment, numLines, reanchorInterval);
+    size_t first = out.size();
+    out.resize(first + stepper.fillCount());
+    stepper.fill(&out[first]);
+}
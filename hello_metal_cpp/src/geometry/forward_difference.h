@@ -0,0 +1,43 @@
+#pragma once
+#include "bezier.h"
+
+// Steps a cubic at a fixed dt using forward differences: three additions per point instead
+// of a full Bernstein evaluation. Float error grows with every step, so the stepper
+// re-anchors to the exact polynomial every `reanchorInterval` steps.
+class ForwardDifferenceStepper {
+    public:
+        ForwardDifferenceStepper(const CubicSegment& segment, int numSteps, int reanchorInterval = 64);
+
+        // Point at the current step, then advances. Valid for numSteps + 1 calls.
+        Point2 next() {
+            Point2 result = point;
+            current++;
+            if (--untilAnchor == 0) {
+                anchor(current);
+            } else {
+                point.x += delta1.x; point.y += delta1.y;
+                delta1.x += delta2.x; delta1.y += delta2.y;
+                delta2.x += delta3.x; delta2.y += delta3.y;
+            }
+            return result;
+        }
+        int step() const { return current; }
+
+        // Writes all numSteps + 1 points to out[0..numSteps], starting from step 0. Works on
+        // local copies of the differences so the compiler can keep them in registers.
+        void fill(Point2* out);
+        int fillCount() const { return steps + 1; }
+
+    private:
+        void anchor(int atStep);
+
+        // P(t) = a t^3 + b t^2 + c t + d
+        Point2 a, b, c, d;
+        int steps, interval, current, untilAnchor;
+        Point2 point, delta1, delta2, delta3;
+};
+
+namespace Bezier {
+    // numLines + 1 evenly spaced points (t = i / numLines) through the stepper.
+    void sampleUniform(const CubicSegment& segment, int numLines, std::vector<Point2>& out, int reanchorInterval = 64);
+}
@@ -0,0 +1,33 @@
+#include "indexed_mesh.h"
+#include <cstring>
+
+std::span<const std::byte> IndexedMesh::indexBytes() const {
+    return indexType() == MeshIndexType::UInt16 ? asBytes(indices16) : asBytes(indices32);
+}
+
+std::vector<CurveCache::Blob> IndexedMesh::cacheBlobs(uint32_t baseTag, std::span<const std::byte> key) const {
+    return {
+        { baseTag, key },
+        { baseTag + 1, asBytes(vertices) },
+        { baseTag + 2, indexBytes() },
+        { baseTag + 3, asBytes(ranges) },
+    };
+}
+
+bool IndexedMesh::findCached(const CurveCacheFile& cache, uint32_t baseTag, std::span<const std::byte> key,
+                             std::span<const std::byte>& vertexBytes, std::span<const std::byte>& indexBytes,
+                             std::span<const MeshRange>& ranges) {
+    std::span<const std::byte> cachedKey = cache.blob(baseTag);
+    if (cachedKey.size() != key.size() || memcmp(cachedKey.data(), key.data(), key.size()) != 0) {
+        return false;
+    }
+    vertexBytes = cache.blob(baseTag + 1);
+    indexBytes = cache.blob(baseTag + 2);
+    std::span<const std::byte> rangeBytes = cache.blob(baseTag + 3);
+    if (rangeBytes.size() % sizeof(MeshRange) != 0) {
+        return false;
+    }
+    ranges = { reinterpret_cast<const MeshRange*>(rangeBytes.data()), rangeBytes.size() / sizeof(MeshRange) };
+    return vertexBytes.size() % sizeof(MeshVertex) == 0
+        && indexBytes.size() % (size_t)indexTypeFor(vertexBytes.size() / sizeof(MeshVertex)) == 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "bezier.h"
+#include "curve_cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Vertex as the shaders read it: same layout as Vertex in config.h (simd::float2 position,
+// simd::float3 color padded to 16 bytes), in plain floats so it builds without Metal.
+struct MeshVertex {
+    float pos[2] = { 0.0f, 0.0f };
+    float padding0[2] = { 0.0f, 0.0f };
+    float color[3] = { 0.0f, 0.0f, 0.0f };
+    float padding1 = 0.0f;
+};
+
+// Bytes per index; values match the index sizes the GPU accepts.
+enum class MeshIndexType : uint32_t {
+    UInt16 = 2,
+    UInt32 = 4,
+};
+
+// One path of the mesh: a contiguous run of the index buffer holding the path's line strip,
+// then the normal quad strips of its segments, each strip ended by the restart index. Enough
+// to draw or cull the path on its own. StrokeMesh and FillMesh use it for their triangles.
+struct MeshRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t shapeId = 0;
+    int32_t pathId = 0;
+    Box2 bounds;  // of the path's vertices, in NDC
+};
+
+// First of the four curve cache blobs of each kind of mesh: key, vertices, indices, ranges.
+// All of them can share one cache file.
+enum MeshCacheTag : uint32_t {
+    kLineMeshTag = CurveCache::kFirstBlobTag,
+    kStrokeMeshTag = CurveCache::kFirstBlobTag + 0x10,
+    kFillMeshTag = CurveCache::kFirstBlobTag + 0x20,
+};
+
+template <typename T>
+std::span<const std::byte> asBytes(const T* data, size_t count) {
+    return { reinterpret_cast<const std::byte*>(data), count * sizeof(T) };
+}
+
+template <typename T>
+std::span<const std::byte> asBytes(const std::vector<T>& items) {
+    return asBytes(items.data(), items.size());
+}
+
+// Vertices and indices as SvgMesh, StrokeMesh and FillMesh build them, plus their curve cache
+// blobs under a key of raw bytes; CachedMesh below types the key.
+struct IndexedMesh {
+    std::vector<MeshVertex> vertices;
+    // Exactly one of these is filled, see indexTypeFor
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;
+    std::vector<MeshRange> ranges;
+
+    // 16-bit indices while every vertex fits below 0xFFFF (kept free as the strip restart
+    // index), 32-bit beyond that.
+    static MeshIndexType indexTypeFor(size_t vertexCount) {
+        return vertexCount < 0xFFFF ? MeshIndexType::UInt16 : MeshIndexType::UInt32;
+    }
+    // All bits set: ends a line strip without drawing a line to the next index.
+    static uint32_t restartIndex(MeshIndexType type) {
+        return type == MeshIndexType::UInt16 ? 0xFFFF : 0xFFFFFFFF;
+    }
+    MeshIndexType indexType() const { return indexTypeFor(vertices.size()); }
+    size_t indexCount() const { return indices16.size() + indices32.size(); }
+    std::span<const std::byte> indexBytes() const;
+
+    // The mesh as blobs from baseTag on; the spans point into this mesh and `key`.
+    std::vector<CurveCache::Blob> cacheBlobs(uint32_t baseTag, std::span<const std::byte> key) const;
+    // The raw vertex and index bytes and the ranges of the mesh stored from baseTag on, false
+    // if its key differs from `key` or the sizes do not add up; the index type follows from
+    // the vertex count.
+    static bool findCached(const CurveCacheFile& cache, uint32_t baseTag, std::span<const std::byte> key,
+                           std::span<const std::byte>& vertexBytes, std::span<const std::byte>& indexBytes,
+                           std::span<const MeshRange>& ranges);
+};
+
+// An IndexedMesh cached under Key, a plain struct with an `options` member and no padding,
+// compared byte for byte. Key carries a version to bump whenever the mesh built for the same
+// input changes.
+template <typename Key, uint32_t BaseTag>
+struct CachedMesh : IndexedMesh {
+    Key key;
+
+    std::vector<CurveCache::Blob> cacheBlobs() const { return IndexedMesh::cacheBlobs(BaseTag, asBytes(&key, 1)); }
+
+    template <typename Options>
+    static bool findCached(const CurveCacheFile& cache, const Options& options,
+                           std::span<const std::byte>& vertexBytes, std::span<const std::byte>& indexBytes,
+                           std::span<const MeshRange>& ranges) {
+        Key wanted;
+        wanted.options = options;
+        return IndexedMesh::findCached(cache, BaseTag, asBytes(&wanted, 1), vertexBytes, indexBytes, ranges);
+    }
+};
@@ -0,0 +1,368 @@
+#include "offset_curve.h"
+#include "parallel.h"
+#include "polynomial.h"
+#include <algorithm>
+#include <cmath>
+
+// A derivative counts as vanished below this fraction of the control polygon's size, squared,
+// as in Bezier::evaluateFrames
+static const float kVanishing = 1e-10f;
+// Samples per segment when looking for curvature extrema and cusps
+static const int kSplitSamples = 64;
+// Splits closer than this in t are merged, and none are made this close to the ends
+static const float kMinSplitGap = 1e-4f;
+// Control point differences below this fraction of the coordinates are rounding
+static const float kRounding = 1e-5f;
+// Rays along the normal that check a fit
+static const int kErrorSamples = 16;
+// Segments per work item of offsetCurves
+static const size_t kBatchBlock = 256;
+
+static float cross(Point2 a, Point2 b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static float dot(Point2 a, Point2 b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+static Point2 add(Point2 a, Point2 b, float scale = 1.0f) {
+    return { a.x + scale * b.x, a.y + scale * b.y };
+}
+
+static Point2 sub(Point2 a, Point2 b) {
+    return { a.x - b.x, a.y - b.y };
+}
+
+static float sizeSq(const CubicSegment& c) {
+    Point2 a = sub(c.p1, c.p0), b = sub(c.p2, c.p1), d = sub(c.p3, c.p2);
+    return dot(a, a) + dot(b, b) + dot(d, d);
+}
+
+// Unit tangent with the fallbacks of Bezier::evaluateFrames: the derivative, else the one-sided
+// limit from the second derivative, the third difference, the chord. Zero for a point.
+static Point2 unitTangent(const CubicSegment& c, float t) {
+    float threshold = kVanishing * sizeSq(c);
+    Point2 tangent = Bezier::derivative(c, t);
+    if (!(threshold < dot(tangent, tangent))) {
+        Point2 second = Bezier::secondDerivative(c, t);
+        float side = t < 1.0f ? 1.0f : -1.0f;
+        tangent = { side * second.x, side * second.y };
+    }
+    if (!(threshold < dot(tangent, tangent))) {
+        tangent = { c.p3.x - 3 * c.p2.x + 3 * c.p1.x - c.p0.x, c.p3.y - 3 * c.p2.y + 3 * c.p1.y - c.p0.y };
+    }
+    if (!(threshold < dot(tangent, tangent))) {
+        tangent = sub(c.p3, c.p0);
+    }
+    float length = std::sqrt(dot(tangent, tangent));
+    return length > 0.0f ? Point2{ tangent.x / length, tangent.y / length } : Point2{ 0.0f, 0.0f };
+}
+
+static Point2 leftNormal(Point2 tangent) {
+    return { -tangent.y, tangent.x };
+}
+
+// Signed curvature, 0 where the derivative vanishes
+static float curvature(const CubicSegment& c, float t) {
+    Point2 d = Bezier::derivative(c, t);
+    Point2 dd = Bezier::secondDerivative(c, t);
+    float speedSq = dot(d, d);
+    if (!(kVanishing * sizeSq(c) < speedSq)) {
+        return 0.0f;
+    }
+    return cross(d, dd) / (speedSq * std::sqrt(speedSq));
+}
+
+// The part of c between t0 and t1, as its own cubic
+static CubicSegment piece(const CubicSegment& c, float t0, float t1) {
+    CubicSegment left = c, right;
+    if (t1 < 1.0f) {
+        Bezier::split(c, t1, left, right);
+    }
+    if (t0 > 0.0f) {
+        CubicSegment before;
+        Bezier::split(left, t0 / t1, before, right);
+        return right;
+    }
+    return left;
+}
+
+void Bezier::offsetSplits(const CubicSegment& c, float distance, std::vector<float>& ts) {
+    ts.clear();
+
+    // Inflections: B' x B'' is quadratic in t, with B'/3 = a + 2tE + t^2 F and B''/6 = E + tF
+    Point2 a = sub(c.p1, c.p0);
+    Point2 e = sub(sub(c.p2, c.p1), a);
+    Point2 f = sub(sub(c.p3, c.p2), add(a, e, 2.0f));
+    float roots[2];
+    int count = Polynomial::solveQuadratic(cross(e, f), cross(a, f), cross(a, e), roots);
+    for (int i = 0; i < count; i++) {
+        ts.push_back(roots[i]);
+    }
+
+    // Curvature extrema and cusps of the offset, bracketed by sampling and then refined
+    float k[kSplitSamples + 1];
+    float largest = 0.0f;
+    for (int i = 0; i <= kSplitSamples; i++) {
+        k[i] = curvature(c, (float)i / kSplitSamples);
+        largest = std::max(largest, std::fabs(k[i]));
+    }
+    // Changes of curvature too small to matter for the offset are noise
+    float noise = std::max(1e-6f * largest, 1e-3f / std::max(std::fabs(distance), 1e-12f));
+    for (int i = 1; i < kSplitSamples; i++) {
+        float rise = k[i] - k[i - 1], next = k[i + 1] - k[i];
+        if ((rise > 0.0f) == (next > 0.0f) || std::fabs(rise) + std::fabs(next) < noise) {
+            continue;
+        }
+        // Golden section search for the extremum of sign * curvature
+        float sign = rise > 0.0f ? 1.0f : -1.0f;
+        float lo = (float)(i - 1) / kSplitSamples, hi = (float)(i + 1) / kSplitSamples;
+        const float ratio = 0.618034f;
+        float m1 = hi - ratio * (hi - lo), m2 = lo + ratio * (hi - lo);
+        float k1 = sign * curvature(c, m1), k2 = sign * curvature(c, m2);
+        for (int iteration = 0; iteration < 24; iteration++) {
+            if (k1 < k2) {
+                lo = m1;
+                m1 = m2;
+                k1 = k2;
+                m2 = lo + ratio * (hi - lo);
+                k2 = sign * curvature(c, m2);
+            } else {
+                hi = m2;
+                m2 = m1;
+                k2 = k1;
+                m1 = hi - ratio * (hi - lo);
+                k1 = sign * curvature(c, m1);
+            }
+        }
+        ts.push_back(0.5f * (lo + hi));
+    }
+    if (distance != 0.0f) {
+        // The offset's speed is the curve's times 1 - distance * curvature
+        for (int i = 0; i < kSplitSamples; i++) {
+            bool before = 1.0f - distance * k[i] > 0.0f;
+            if (before == (1.0f - distance * k[i + 1] > 0.0f)) {
+                continue;
+            }
+            float lo = (float)i / kSplitSamples, hi = (float)(i + 1) / kSplitSamples;
+            for (int iteration = 0; iteration < 24; iteration++) {
+                float middle = 0.5f * (lo + hi);
+                if ((1.0f - distance * curvature(c, middle) > 0.0f) == before) {
+                    lo = middle;
+                } else {
+                    hi = middle;
+                }
+            }
+            ts.push_back(0.5f * (lo + hi));
+        }
+    }
+
+    std::sort(ts.begin(), ts.end());
+    size_t kept = 0;
+    for (float t : ts) {
+        if (t > kMinSplitGap && t < 1.0f - kMinSplitGap && (kept == 0 || t - ts[kept - 1] > kMinSplitGap)) {
+            ts[kept++] = t;
+        }
+    }
+    ts.resize(kept);
+}
+
+static Point2 tangentOf(Point2 normal) {
+    return { normal.y, -normal.x };
+}
+
+// The offset of the curve at t along the normal n
+static Point2 offsetPoint(const CubicSegment& c, float t, Point2 n, float distance) {
+    return add(Bezier::evaluate(c, t), n, distance);
+}
+
+// Control polygon legs of `part`, from t0 to t1 on c, offset by `distance` and intersected
+// (Tiller-Hanson), between the offset end points `start` and `end` with normals n0 and n1. The
+// outer legs lie along the end tangents; a middle leg lost to rounding takes the tangent of c
+// halfway, and parallel neighbours the offset of their shared control point.
+static CubicSegment tillerHanson(const CubicSegment& c, float t0, float t1, const CubicSegment& part, float distance,
+                                 Point2 start, Point2 n0, Point2 end, Point2 n1) {
+    Point2 middle = sub(part.p2, part.p1);
+    float scale = std::max({ std::fabs(part.p1.x), std::fabs(part.p1.y), std::fabs(part.p2.x), std::fabs(part.p2.y) });
+    float length = std::sqrt(dot(middle, middle));
+    Point2 directions[3] = { tangentOf(n0), { middle.x / length, middle.y / length }, tangentOf(n1) };
+    if (!(length > kRounding * scale)) {
+        directions[1] = unitTangent(c, 0.5f * (t0 + t1));
+    }
+    auto intersect = [&](Point2 corner, int first) {
+        Point2 u = directions[first], v = directions[first + 1];
+        Point2 a = add(corner, leftNormal(u), distance);
+        Point2 b = add(corner, leftNormal(v), distance);
+        float denominator = cross(u, v);
+        if (std::fabs(denominator) < 1e-4f) {
+            return a;
+        }
+        return add(a, u, cross(sub(b, a), v) / denominator);
+    };
+    return { start, intersect(part.p1, 0), intersect(part.p2, 1), end };
+}
+
+// The offset end points with the curve's end tangents, handles scaled by the offset's speed
+// 1 - distance * curvature, so the fit matches the offset's derivative at both ends
+static CubicSegment scaledHandles(const CubicSegment& part, float k0, float k1, float distance,
+                                  Point2 start, Point2 n0, Point2 end, Point2 n1) {
+    Point2 a = sub(part.p1, part.p0), b = sub(part.p3, part.p2);
+    float first = std::sqrt(dot(a, a)) * (1.0f - distance * k0);
+    float last = std::sqrt(dot(b, b)) * (1.0f - distance * k1);
+    return { start, add(start, tangentOf(n0), first), add(end, tangentOf(n1), -last), end };
+}
+
+// Largest miss along rays from the curve between t0 and t1 in the normal direction: where each
+// ray meets the fit, how far that is from `distance`. Rays that miss the fit fall back to the
+// closest point. The rays are denser towards the ends, where a vanishing derivative turns the
+// normal fastest. Stops at the first miss over `limit`.
+static float fitError(const CubicSegment& c, float t0, float t1, float distance, const CubicSegment& fit,
+                      float limit = INFINITY) {
+    // Power basis of the fit
+    Point2 d3 = { fit.p3.x - 3 * fit.p2.x + 3 * fit.p1.x - fit.p0.x, fit.p3.y - 3 * fit.p2.y + 3 * fit.p1.y - fit.p0.y };
+    Point2 d2 = { 3 * (fit.p2.x - 2 * fit.p1.x + fit.p0.x), 3 * (fit.p2.y - 2 * fit.p1.y + fit.p0.y) };
+    Point2 d1 = { 3 * (fit.p1.x - fit.p0.x), 3 * (fit.p1.y - fit.p0.y) };
+    float worst = 0.0f;
+    for (int i = 0; i < kErrorSamples; i++) {
+        float t = t0 + (t1 - t0) * (0.5f - 0.5f * std::cos((float)M_PI * (i + 0.5f) / kErrorSamples));
+        Point2 normal = leftNormal(unitTangent(c, t));
+        if (normal.x == 0.0f && normal.y == 0.0f) {
+            continue;
+        }
+        Point2 origin = Bezier::evaluate(c, t);
+        float roots[3];
+        int count = Polynomial::solveCubic(cross(d3, normal), cross(d2, normal), cross(d1, normal),
+                                           cross(sub(fit.p0, origin), normal), roots);
+        float error = INFINITY;
+        for (int r = 0; r < count; r++) {
+            if (roots[r] >= -0.01f && roots[r] <= 1.01f) {
+                error = std::min(error, std::fabs(dot(sub(Bezier::evaluate(fit, roots[r]), origin), normal) - distance));
+            }
+        }
+        if (error == INFINITY) {
+            error = std::sqrt(Bezier::closestPoint(fit, add(origin, normal, distance)).distanceSq);
+        }
+        worst = std::max(worst, error);
+        if (worst > limit) {
+            break;
+        }
+    }
+    return worst;
+}
+
+// Fits the offset of c between t0 and t1, with normals n0 and n1 there, halving until it is
+// close enough. Normals, curvature and the checks come from c itself rather than from the
+// split-off part, whose control points lose the tangent to rounding once the part is short;
+// both halves take the offset at the split from the same evaluation, so they meet exactly.
+static void fitPiece(const CubicSegment& c, float t0, float t1, float distance, Point2 n0, Point2 n1,
+                     const OffsetCurveOptions& options, int depth, std::vector<CubicSegment>& out) {
+    CubicSegment part = piece(c, t0, t1);
+    Point2 start = offsetPoint(c, t0, n0, distance), end = offsetPoint(c, t1, n1, distance);
+    // Below the last halving a fit only has to pass; at it the closer of the two is kept
+    float limit = depth < options.maxDepth ? options.tolerance : INFINITY;
+    CubicSegment best = tillerHanson(c, t0, t1, part, distance, start, n0, end, n1);
+    float error = fitError(c, t0, t1, distance, best, limit);
+    if (error > options.tolerance) {
+        CubicSegment scaled = scaledHandles(part, curvature(c, t0), curvature(c, t1), distance, start, n0, end, n1);
+        float scaledError = fitError(c, t0, t1, distance, scaled, limit);
+        if (scaledError < error) {
+            best = scaled;
+            error = scaledError;
+        }
+    }
+    if (error <= options.tolerance || depth >= options.maxDepth) {
+        out.push_back(best);
+        return;
+    }
+    float middle = 0.5f * (t0 + t1);
+    Point2 normal = leftNormal(unitTangent(c, middle));
+    fitPiece(c, t0, middle, distance, n0, normal, options, depth + 1, out);
+    fitPiece(c, middle, t1, distance, normal, n1, options, depth + 1, out);
+}
+
+// Circular arc of radius |distance| around a cusp of the curve, from the offset before it to
+// the offset after it, around the tip the curve came in along `tangent`; at most a quarter
+// turn per cubic
+static void cuspArc(Point2 center, float distance, Point2 before, Point2 after, Point2 tangent, std::vector<CubicSegment>& out) {
+    float radius = std::fabs(distance);
+    Point2 from = distance < 0.0f ? Point2{ -before.x, -before.y } : before;
+    Point2 to = distance < 0.0f ? Point2{ -after.x, -after.y } : after;
+    float sweep = std::atan2(cross(from, to), dot(from, to));
+    float halfway = std::atan2(from.y, from.x) + 0.5f * sweep;
+    if (std::cos(halfway) * tangent.x + std::sin(halfway) * tangent.y < 0.0f) {
+        sweep -= sweep > 0.0f ? 2.0f * (float)M_PI : -2.0f * (float)M_PI;
+    }
+    int pieces = std::max(1, (int)std::ceil(std::fabs(sweep) / (0.5f * (float)M_PI) - 1e-4f));
+    float step = sweep / pieces;
+    float handle = 4.0f / 3.0f * std::tan(step / 4.0f) * radius;
+    float angle = std::atan2(from.y, from.x);
+    for (int i = 0; i < pieces; i++, angle += step) {
+        Point2 a = { std::cos(angle), std::sin(angle) };
+        Point2 b = { std::cos(angle + step), std::sin(angle + step) };
+        Point2 p0 = add(center, a, radius), p3 = add(center, b, radius);
+        out.push_back({ p0, add(p0, leftNormal(a), handle), add(p3, leftNormal(b), -handle), p3 });
+    }
+}
+
+void Bezier::offsetCurve(const CubicSegment& c, float distance, std::vector<CubicSegment>& out,
+                         const OffsetCurveOptions& options) {
+    if (sizeSq(c) == 0.0f) {
+        return;
+    }
+    std::vector<float> ts;
+    offsetSplits(c, distance, ts);
+    ts.push_back(1.0f);
+
+    // Neighbouring pieces share the normal at their split, except across a cusp of the curve
+    // itself, where the tangent turns around and the offset jumps: an arc bridges it
+    float t0 = 0.0f;
+    Point2 start = leftNormal(unitTangent(c, 0.0f));
+    for (float t1 : ts) {
+        if (t1 == 1.0f) {
+            fitPiece(c, t0, 1.0f, distance, start, leftNormal(unitTangent(c, 1.0f)), options, 0, out);
+            break;
+        }
+        Point2 before = leftNormal(unitTangent(c, t1 - 0.5f * kMinSplitGap));
+        Point2 after = leftNormal(unitTangent(c, t1 + 0.5f * kMinSplitGap));
+        if (dot(before, after) > 0.0f) {
+            Point2 normal = leftNormal(unitTangent(c, t1));
+            fitPiece(c, t0, t1, distance, start, normal, options, 0, out);
+            start = normal;
+        } else {
+            fitPiece(c, t0, t1, distance, start, before, options, 0, out);
+            cuspArc(Bezier::evaluate(c, t1), distance, before, after, tangentOf(before), out);
+            start = after;
+        }
+        t0 = t1;
+    }
+}
+
+OffsetCurves Bezier::offsetCurves(const CubicSegmentsSoA& segments, float distance, const OffsetCurveOptions& options) {
+    OffsetCurves result;
+    const size_t count = segments.size();
+    result.firstPiece.resize(count + 1, 0);
+
+    // Blocks of segments on the work-stealing pool, each into its own buffer; the piece
+    // counts go straight into firstPiece and become offsets below
+    const size_t blocks = (count + kBatchBlock - 1) / kBatchBlock;
+    std::vector<std::vector<CubicSegment>> blockCubics(blocks);
+    Parallel::forEach(blocks, [&](size_t block) {
+        std::vector<CubicSegment>& cubics = blockCubics[block];
+        size_t end = std::min(count, (block + 1) * kBatchBlock);
+        for (size_t s = block * kBatchBlock; s < end; s++) {
+            size_t before = cubics.size();
+            offsetCurve(segments.get(s), distance, cubics, options);
+            result.firstPiece[s + 1] = (uint32_t)(cubics.size() - before);
+        }
+    });
+
+    for (size_t s = 0; s < count; s++) {
+        result.firstPiece[s + 1] += result.firstPiece[s];
+    }
+    result.cubics.reserve(result.firstPiece[count]);
+    for (const std::vector<CubicSegment>& cubics : blockCubics) {
+        result.cubics.insert(result.cubics.end(), cubics.begin(), cubics.end());
+    }
+    return result;
+}
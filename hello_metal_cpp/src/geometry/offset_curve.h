@@ -0,0 +1,38 @@
+#pragma once
+#include "bezier.h"
+#include "bezier_batch.h"
+#include <cstdint>
+#include <vector>
+
+struct OffsetCurveOptions {
+    float tolerance = 0.001f;  // max distance from the true offset, in the units of the points
+    int maxDepth = 8;          // halvings of a piece before its best fit is kept as is
+};
+
+// Offsets of a batch of segments as cubics: the pieces of segment s are
+// cubics[firstPiece[s]] .. cubics[firstPiece[s + 1]], in order along the segment.
+struct OffsetCurves {
+    std::vector<CubicSegment> cubics;
+    std::vector<uint32_t> firstPiece;  // one entry per segment plus the end
+};
+
+namespace Bezier {
+    // Parameters in (0, 1) where the offset at `distance` gets a new piece, sorted: the
+    // inflections, the curvature extrema, and the offset's cusps where distance * curvature
+    // reaches 1, i.e. where the distance exceeds the radius of curvature on the inner side.
+    void offsetSplits(const CubicSegment& c, float distance, std::vector<float>& ts);
+
+    // Appends cubics within options.tolerance of the offset of `c` by `distance` along the
+    // normals of Bezier::evaluateFrames (negative for the other side). The pieces between
+    // offsetSplits are fitted by Tiller-Hanson or by end tangents with curvature-scaled
+    // handles, whichever is closer, and halved until they fit. Past a cusp of the offset it
+    // runs backwards; that swallowtail is kept, not trimmed. Across a cusp of `c` itself the
+    // offset jumps to the other side, bridged by a circular arc around the cusp. A segment
+    // that is a single point has no offset.
+    void offsetCurve(const CubicSegment& c, float distance, std::vector<CubicSegment>& out,
+                     const OffsetCurveOptions& options = OffsetCurveOptions());
+
+    // offsetCurve for every segment, in parallel.
+    OffsetCurves offsetCurves(const CubicSegmentsSoA& segments, float distance,
+                              const OffsetCurveOptions& options = OffsetCurveOptions());
+}
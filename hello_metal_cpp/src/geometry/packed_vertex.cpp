@@ -0,0 +1,86 @@
+#include "packed_vertex.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+static const float kQuantizationSteps = 65535.0f;
+
+static uint16_t quantize(float value, float origin, float scale) {
+    float q = scale > 0.0f ? (value - origin) / scale * kQuantizationSteps : 0.0f;
+    if (!(q > 0.0f)) {
+        return 0;
+    }
+    return q >= kQuantizationSteps ? (uint16_t)65535 : (uint16_t)(q + 0.5f);
+}
+
+static std::array<uint32_t, 3> colorKey(const float* color) {
+    std::array<uint32_t, 3> key;
+    memcpy(key.data(), color, sizeof(key));
+    return key;
+}
+
+bool PackedMesh::pack(std::span<const MeshVertex> vertices, PackedMesh& out) {
+    out = PackedMesh();
+    Box2 bounds;
+    for (const MeshVertex& v : vertices) {
+        bounds.expand(Point2{ v.pos[0], v.pos[1] });
+    }
+    if (vertices.empty() || !(bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y)) {
+        bounds = Box2();
+        bounds.expand(Point2{ 0.0f, 0.0f });
+    }
+    PackedMeshUniforms& uniforms = out.uniforms;
+    uniforms.origin[0] = bounds.min.x;
+    uniforms.origin[1] = bounds.min.y;
+    uniforms.scale[0] = bounds.max.x - bounds.min.x;
+    uniforms.scale[1] = bounds.max.y - bounds.min.y;
+
+    // Runs of one color are the norm, so the map is only consulted when the color changes
+    std::map<std::array<uint32_t, 3>, uint16_t> paletteIndex;
+    std::array<uint32_t, 3> lastKey = {};
+    uint16_t lastIndex = 0;
+    out.vertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const MeshVertex& v = vertices[i];
+        std::array<uint32_t, 3> key = colorKey(v.color);
+        if (i == 0 || key != lastKey) {
+            auto [it, inserted] = paletteIndex.try_emplace(key, (uint16_t)out.palette.size());
+            if (inserted) {
+                if (out.palette.size() == kMaxPaletteSize) {
+                    out = PackedMesh();
+                    return false;
+                }
+                out.palette.push_back({ { v.color[0], v.color[1], v.color[2], 1.0f } });
+            }
+            lastKey = key;
+            lastIndex = it->second;
+        }
+        PackedVertex& p = out.vertices[i];
+        if (std::isnan(v.pos[0]) || std::isnan(v.pos[1])) {
+            // Not representable; collapse onto the previous vertex instead of jumping to the origin
+            p = i > 0 ? out.vertices[i - 1] : PackedVertex();
+        } else {
+            p.x = quantize(v.pos[0], uniforms.origin[0], uniforms.scale[0]);
+            p.y = quantize(v.pos[1], uniforms.origin[1], uniforms.scale[1]);
+        }
+        p.color = lastIndex;
+    }
+    return true;
+}
+
+MeshVertex PackedMesh::unpack(size_t i) const {
+    const PackedVertex& p = vertices[i];
+    const PackedColor& c = palette[p.color];
+    MeshVertex v;
+    v.pos[0] = uniforms.origin[0] + p.x / kQuantizationSteps * uniforms.scale[0];
+    v.pos[1] = uniforms.origin[1] + p.y / kQuantizationSteps * uniforms.scale[1];
+    v.color[0] = c.rgba[0];
+    v.color[1] = c.rgba[1];
+    v.color[2] = c.rgba[2];
+    return v;
+}
+
+Point2 PackedMesh::maxError() const {
+    return { 0.5f * uniforms.scale[0] / kQuantizationSteps, 0.5f * uniforms.scale[1] / kQuantizationSteps };
+}
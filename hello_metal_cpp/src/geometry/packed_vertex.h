@@ -0,0 +1,50 @@
+#pragma once
+#include "svg_mesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// 8-byte vertex: the position quantized to 16 bits per axis across the mesh bounds and the
+// color as an index into the mesh palette. A quarter of MeshVertex's 32 bytes.
+struct PackedVertex {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t color = 0;
+    uint16_t padding = 0;  // strides must be a multiple of 4
+};
+
+static constexpr VertexLayout kPackedVertexLayout = {
+    { VertexAttributeFormat::UShort2Normalized, offsetof(PackedVertex, x) },
+    { VertexAttributeFormat::UShort, offsetof(PackedVertex, color) },
+    sizeof(PackedVertex),
+};
+
+// Vertex shader constants of a packed mesh, laid out as PackedMeshUniforms in
+// general_shader.metal: position = origin + (x, y) / 65535 * scale.
+struct PackedMeshUniforms {
+    float origin[2] = { 0.0f, 0.0f };
+    float scale[2] = { 0.0f, 0.0f };
+};
+
+// Palette entry, float4 so the shader can index it as a constant array.
+struct PackedColor {
+    float rgba[4];
+};
+
+struct PackedMesh {
+    std::vector<PackedVertex> vertices;
+    std::vector<PackedColor> palette;
+    PackedMeshUniforms uniforms;
+
+    static constexpr size_t kMaxPaletteSize = 65536;
+
+    // Quantizes positions to the bounds of `vertices` and gathers the distinct colors into
+    // the palette. NaN positions take the previous vertex's. False if there are more than
+    // kMaxPaletteSize colors.
+    static bool pack(std::span<const MeshVertex> vertices, PackedMesh& out);
+    // Decodes vertex i the way the shader does.
+    MeshVertex unpack(size_t i) const;
+    // Position error bound of the quantization per axis: half a step, plus float rounding.
+    Point2 maxError() const;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+    // Set on every thread that runs a share of a forRange or forEach spread over more than one
+    // thread. Calls nested in such a share run on the calling thread, so a parallel job that
+    // itself builds in parallel stays at the outer call's thread count instead of multiplying it.
+    inline thread_local bool nested = false;
+
+    struct NestedScope {
+        bool previous = nested;
+        NestedScope() { nested = true; }
+        ~NestedScope() { nested = previous; }
+    };
+
+    // Threads a parallel call started here may use: all cores, or 1 inside another call's share
+    inline unsigned threadCount() {
+        if (nested) {
+            return 1;
+        }
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    // Splits [0, count) into contiguous chunks of at least minChunk items and runs
+    // body(begin, end) on each, one chunk per thread. Blocks until all chunks finished.
+    template <typename Body>
+    void forRange(size_t count, Body&& body, size_t minChunk = 1024) {
+        size_t chunks = std::min<size_t>(threadCount(), (count + minChunk - 1) / std::max<size_t>(minChunk, 1));
+        if (chunks <= 1) {
+            if (count > 0) {
+                body(size_t(0), count);
+            }
+            return;
+        }
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        for (size_t c = 1; c < chunks; c++) {
+            size_t begin = c * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            if (begin < end) {
+                workers.emplace_back([&body, begin, end] {
+                    NestedScope scope;
+                    body(begin, end);
+                });
+            }
+        }
+        {
+            NestedScope scope;
+            body(size_t(0), std::min(count, chunkSize));
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Runs body(i) for every i in [0, count) on up to `threads` threads, or on the calling thread
+    // inside another call's share. Each thread starts on its own contiguous share and, once that
+    // runs dry, steals the back half of the largest share left, so items of very different cost
+    // still keep every thread busy.
+    template <typename Body>
+    void forEach(size_t count, Body&& body, unsigned threads = threadCount()) {
+        struct Share {
+            std::mutex lock;
+            size_t begin = 0;
+            size_t end = 0;
+        };
+        threads = nested ? 1u : (unsigned)std::min<size_t>(std::max(threads, 1u), std::max<size_t>(count, 1));
+        std::vector<Share> shares(threads);
+        for (unsigned t = 0; t < threads; t++) {
+            shares[t].begin = count * t / threads;
+            shares[t].end = count * (t + 1) / threads;
+        }
+        auto work = [&](unsigned self) {
+            std::optional<NestedScope> scope;
+            if (threads > 1) {
+                scope.emplace();
+            }
+            Share& own = shares[self];
+            for (;;) {
+                size_t item = SIZE_MAX;
+                {
+                    std::lock_guard<std::mutex> guard(own.lock);
+                    if (own.begin < own.end) {
+                        item = own.begin++;
+                    }
+                }
+                if (item != SIZE_MAX) {
+                    body(item);
+                    continue;
+                }
+                // Only owners refill their share, so all shares empty means nothing is left to take
+                unsigned victim = self;
+                size_t most = 0;
+                for (unsigned t = 0; t < threads; t++) {
+                    std::lock_guard<std::mutex> guard(shares[t].lock);
+                    if (shares[t].end - shares[t].begin > most) {
+                        most = shares[t].end - shares[t].begin;
+                        victim = t;
+                    }
+                }
+                if (most == 0) {
+                    return;
+                }
+                size_t stolenBegin, stolenEnd;
+                {
+                    std::lock_guard<std::mutex> guard(shares[victim].lock);
+                    size_t remaining = shares[victim].end - shares[victim].begin;
+                    stolenEnd = shares[victim].end;
+                    stolenBegin = stolenEnd - (remaining + 1) / 2;
+                    shares[victim].end = stolenBegin;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = stolenBegin;
+                own.end = stolenEnd;
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; t++) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+}
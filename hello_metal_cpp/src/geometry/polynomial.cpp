@@ -0,0 +1,58 @@
+#include "polynomial.h"
+#include <cmath>
+
+static const double kEpsilon = 1e-12;
+
+int Polynomial::solveQuadratic(float a, float b, float c, float roots[2]) {
+    if (std::fabs(a) < kEpsilon) {
+        if (std::fabs(b) < kEpsilon) {
+            return 0;
+        }
+        roots[0] = (float)(-(double)c / b);
+        return 1;
+    }
+    double discriminant = (double)b * b - 4.0 * a * c;
+    if (discriminant < 0.0) {
+        return 0;
+    }
+    if (discriminant == 0.0) {
+        roots[0] = (float)(-b / (2.0 * a));
+        return 1;
+    }
+    // Numerically stable form, avoids cancellation between -b and sqrt
+    double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), (double)b));
+    roots[0] = (float)(q / a);
+    roots[1] = (float)(c / q);
+    return 2;
+}
+
+int Polynomial::solveCubic(float a, float b, float c, float d, float roots[3]) {
+    if (std::fabs(a) < kEpsilon) {
+        return solveQuadratic(b, c, d, roots);
+    }
+    // Depressed cubic t = x - B/3: x^3 + p x + q = 0
+    double B = b / (double)a, C = c / (double)a, D = d / (double)a;
+    double p = C - B * B / 3.0;
+    double q = 2.0 * B * B * B / 27.0 - B * C / 3.0 + D;
+    double shift = -B / 3.0;
+    double discriminant = q * q / 4.0 + p * p * p / 27.0;
+    if (discriminant > kEpsilon) {
+        double s = std::sqrt(discriminant);
+        roots[0] = (float)(std::cbrt(-q / 2.0 + s) + std::cbrt(-q / 2.0 - s) + shift);
+        return 1;
+    }
+    if (discriminant > -kEpsilon) {
+        // Repeated root
+        double u = std::cbrt(-q / 2.0);
+        roots[0] = (float)(2.0 * u + shift);
+        roots[1] = (float)(-u + shift);
+        return 2;
+    }
+    // Three real roots, trigonometric form
+    double r = std::sqrt(-p / 3.0);
+    double phi = std::acos(std::fmax(-1.0, std::fmin(1.0, -q / (2.0 * r * r * r))));
+    for (int k = 0; k < 3; k++) {
+        roots[k] = (float)(2.0 * r * std::cos((phi - 2.0 * M_PI * k) / 3.0) + shift);
+    }
+    return 3;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Real roots of low degree polynomials, computed in double. Roots are returned unsorted;
+// degenerate leading coefficients fall back to the lower degree.
+namespace Polynomial {
+    // a t^2 + b t + c = 0, returns the number of roots written (0..2)
+    int solveQuadratic(float a, float b, float c, float roots[2]);
+    // a t^3 + b t^2 + c t + d = 0, returns the number of roots written (0..3)
+    int solveCubic(float a, float b, float c, float d, float roots[3]);
+}
@@ -0,0 +1,218 @@
+#include "segment_bvh.h"
+#include "parallel.h"
+#include "polynomial.h"
+#include <algorithm>
+#include <future>
+
+// Subtrees smaller than this are built on the calling thread
+static const uint32_t kParallelBuildThreshold = 4096;
+
+// Spreads the lower 16 bits of v to the even bits of the result
+static uint32_t expandBits(uint32_t v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static uint32_t mortonCode(const Point2& p, const Box2& scene) {
+    float w = scene.max.x - scene.min.x, h = scene.max.y - scene.min.y;
+    float nx = w > 0.0f ? (p.x - scene.min.x) / w : 0.0f;
+    float ny = h > 0.0f ? (p.y - scene.min.y) / h : 0.0f;
+    uint32_t x = (uint32_t)std::clamp(nx * 65535.0f, 0.0f, 65535.0f);
+    uint32_t y = (uint32_t)std::clamp(ny * 65535.0f, 0.0f, 65535.0f);
+    return expandBits(x) | (expandBits(y) << 1);
+}
+
+SegmentBvh::SegmentBvh(const CubicSegmentsSoA& segments)
+: source(&segments) {
+    const size_t n = segments.size();
+    if (n == 0) {
+        return;
+    }
+    leafBounds.resize(n);
+    Parallel::forRange(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            leafBounds[i] = Bezier::bounds(segments.get(i));
+        }
+    });
+    Box2 scene;
+    for (const Box2& box : leafBounds) {
+        scene.expand(box.center());
+    }
+
+    std::vector<uint64_t> keys(n);
+    Parallel::forRange(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            keys[i] = ((uint64_t)mortonCode(leafBounds[i].center(), scene) << 32) | i;
+        }
+    });
+    std::sort(keys.begin(), keys.end());
+    mortonCodes.resize(n);
+    order.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        mortonCodes[i] = (uint32_t)(keys[i] >> 32);
+        order[i] = (uint32_t)keys[i];
+    }
+
+    nodes.resize(2 * n - 1);
+    build(0, 0, (uint32_t)n - 1, 0);
+}
+
+void SegmentBvh::build(uint32_t node, uint32_t first, uint32_t last, int depth) {
+    if (first == last) {
+        nodes[node] = { leafBounds[order[first]], kInvalid, order[first] };
+        return;
+    }
+    // Split where the highest differing Morton bit changes; identical codes split in the middle
+    uint32_t split;
+    uint32_t firstCode = mortonCodes[first], lastCode = mortonCodes[last];
+    if (firstCode == lastCode) {
+        split = (first + last) / 2;
+    } else {
+        int commonPrefix = __builtin_clz(firstCode ^ lastCode);
+        split = first;
+        uint32_t step = last - first;
+        do {
+            step = (step + 1) / 2;
+            uint32_t candidate = split + step;
+            if (candidate < last && __builtin_clz(firstCode ^ mortonCodes[candidate]) > commonPrefix) {
+                split = candidate;
+            }
+        } while (step > 1);
+    }
+    uint32_t left = node + 1;
+    uint32_t right = node + 2 * (split - first + 1);
+    // Each level doubles the threads; the depth test keeps the shift defined for deep splits
+    if (last - first > kParallelBuildThreshold && depth < 31 && (1u << depth) < Parallel::threadCount()) {
+        auto leftDone = std::async(std::launch::async, [=, this] { build(left, first, split, depth + 1); });
+        build(right, split + 1, last, depth + 1);
+        leftDone.wait();
+    } else {
+        build(left, first, split, depth + 1);
+        build(right, split + 1, last, depth + 1);
+    }
+    Box2 bounds = nodes[left].bounds;
+    bounds.expand(nodes[right].bounds);
+    nodes[node] = { bounds, right, kInvalid };
+}
+
+void SegmentBvh::queryBox(const Box2& box, std::vector<uint32_t>& out) const {
+    if (nodes.empty()) {
+        return;
+    }
+    uint32_t stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!node.bounds.overlaps(box)) {
+            continue;
+        }
+        if (node.segment != kInvalid) {
+            out.push_back(node.segment);
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = (uint32_t)(&node - nodes.data()) + 1;
+        }
+    }
+}
+
+SegmentBvh::NearestHit SegmentBvh::nearest(const Point2& p, float maxDistance) const {
+    NearestHit hit;
+    hit.point.distanceSq = maxDistance * maxDistance;
+    if (nodes.empty()) {
+        return hit;
+    }
+    uint32_t stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const Node& node = nodes[index];
+        if (node.bounds.distanceSq(p) >= hit.point.distanceSq) {
+            continue;
+        }
+        if (node.segment != kInvalid) {
+            CurvePoint candidate = Bezier::closestPoint(source->get(node.segment), p);
+            if (candidate.distanceSq < hit.point.distanceSq) {
+                hit.segment = node.segment;
+                hit.point = candidate;
+            }
+            continue;
+        }
+        // Visit the closer child first so the other one is more likely to be pruned
+        uint32_t left = index + 1, right = node.right;
+        if (nodes[left].bounds.distanceSq(p) < nodes[right].bounds.distanceSq(p)) {
+            std::swap(left, right);
+        }
+        stack[top++] = left;
+        stack[top++] = right;
+    }
+    return hit;
+}
+
+// Slab test, returns the entry distance or INFINITY on a miss
+static float rayBoxEntry(const Box2& box, const Point2& origin, const Point2& inverse, float maxT) {
+    float tx0 = (box.min.x - origin.x) * inverse.x, tx1 = (box.max.x - origin.x) * inverse.x;
+    float ty0 = (box.min.y - origin.y) * inverse.y, ty1 = (box.max.y - origin.y) * inverse.y;
+    float enter = std::fmax(std::fmax(std::fmin(tx0, tx1), std::fmin(ty0, ty1)), 0.0f);
+    float exit = std::fmin(std::fmin(std::fmax(tx0, tx1), std::fmax(ty0, ty1)), maxT);
+    return enter <= exit ? enter : INFINITY;
+}
+
+SegmentBvh::RayHit SegmentBvh::rayCast(const Point2& origin, const Point2& direction, float maxT) const {
+    RayHit hit;
+    hit.rayT = maxT;
+    float lengthSq = direction.x * direction.x + direction.y * direction.y;
+    if (nodes.empty() || lengthSq == 0.0f) {
+        hit.rayT = INFINITY;
+        return hit;
+    }
+    Point2 inverse = { 1.0f / direction.x, 1.0f / direction.y };
+    uint32_t stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const Node& node = nodes[index];
+        if (rayBoxEntry(node.bounds, origin, inverse, hit.rayT) == INFINITY) {
+            continue;
+        }
+        if (node.segment == kInvalid) {
+            stack[top++] = node.right;
+            stack[top++] = index + 1;
+            continue;
+        }
+        // Move the ray onto the x axis: y' is the signed distance (times |direction|) to the
+        // ray line, the hit parameters are the roots of the cubic y'(t)
+        CubicSegment c = source->get(node.segment);
+        float y[4], x[4];
+        const Point2* points[4] = { &c.p0, &c.p1, &c.p2, &c.p3 };
+        for (int k = 0; k < 4; k++) {
+            float dx = points[k]->x - origin.x, dy = points[k]->y - origin.y;
+            y[k] = direction.x * dy - direction.y * dx;
+            x[k] = (direction.x * dx + direction.y * dy) / lengthSq;
+        }
+        float roots[3];
+        int count = Polynomial::solveCubic(-y[0] + 3 * y[1] - 3 * y[2] + y[3], 3 * y[0] - 6 * y[1] + 3 * y[2],
+                                           3 * (y[1] - y[0]), y[0], roots);
+        for (int k = 0; k < count; k++) {
+            float t = roots[k];
+            if (t < 0.0f || t > 1.0f) {
+                continue;
+            }
+            float u = 1.0f - t;
+            float s = u * u * u * x[0] + 3 * u * u * t * x[1] + 3 * u * t * t * x[2] + t * t * t * x[3];
+            if (s >= 0.0f && s <= hit.rayT) {
+                hit = { node.segment, t, s };
+            }
+        }
+    }
+    if (hit.segment == kInvalid) {
+        hit.rayT = INFINITY;
+    }
+    return hit;
+}
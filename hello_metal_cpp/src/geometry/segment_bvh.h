@@ -0,0 +1,54 @@
+#pragma once
+#include "bezier.h"
+#include "bezier_batch.h"
+#include <cstdint>
+#include <vector>
+
+// Flat linear BVH over cubic segments. Leaves hold one segment each, so a subtree over n
+// segments always has 2n - 1 nodes and the depth-first layout is known before building:
+// the left child of node i is i + 1, the right child is stored in the node.
+class SegmentBvh {
+    public:
+        static const uint32_t kInvalid = UINT32_MAX;
+
+        struct Node {
+            Box2 bounds;
+            uint32_t right;    // internal nodes: index of the right child
+            uint32_t segment;  // leaves: segment index, kInvalid for internal nodes
+        };
+
+        struct NearestHit {
+            uint32_t segment = kInvalid;
+            CurvePoint point;
+        };
+
+        struct RayHit {
+            uint32_t segment = kInvalid;
+            float curveT = 0.0f;
+            float rayT = INFINITY;  // hit point = origin + rayT * direction
+        };
+
+        SegmentBvh() = default;
+        // Builds over all segments; Morton codes, sorting and subtrees are spread across threads.
+        explicit SegmentBvh(const CubicSegmentsSoA& segments);
+
+        bool empty() const { return nodes.empty(); }
+        const std::vector<Node>& getNodes() const { return nodes; }
+        const Box2& segmentBounds(uint32_t segment) const { return leafBounds[segment]; }
+
+        // Segments whose tight bounds overlap `box`.
+        void queryBox(const Box2& box, std::vector<uint32_t>& out) const;
+        // Nearest point on any segment, ignoring segments farther than maxDistance.
+        NearestHit nearest(const Point2& p, float maxDistance = INFINITY) const;
+        // First intersection of origin + s * direction, 0 <= s <= maxT, with any segment.
+        RayHit rayCast(const Point2& origin, const Point2& direction, float maxT = INFINITY) const;
+
+    private:
+        void build(uint32_t node, uint32_t first, uint32_t last, int depth);
+
+        const CubicSegmentsSoA* source = nullptr;
+        std::vector<Node> nodes;
+        std::vector<Box2> leafBounds;      // per segment, in input order
+        std::vector<uint32_t> mortonCodes; // sorted
+        std::vector<uint32_t> order;       // segment index per sorted position
+};
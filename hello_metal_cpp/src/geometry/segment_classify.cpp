@@ -0,0 +1,89 @@
+#include "segment_classify.h"
+#include <algorithm>
+
+// Upper bound for the number of pieces Wang's formula may ask for.
+static const int kMaxUniformSubdivisions = 1024;
+
+void SegmentStats::add(SegmentKind kind) {
+    switch (kind) {
+        case SegmentKind::Line: lines++; break;
+        case SegmentKind::Quadratic: quadratics++; break;
+        case SegmentKind::Cubic: cubics++; break;
+    }
+}
+
+// Distance of q from the line through a and b, and its parameter along a->b.
+static void projectOnChord(const Point2& a, const Point2& b, const Point2& q, float& distance, float& t) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float lengthSq = dx * dx + dy * dy;
+    float qx = q.x - a.x, qy = q.y - a.y;
+    if (lengthSq <= 0.0f) {
+        distance = std::sqrt(qx * qx + qy * qy);
+        t = 0.0f;
+        return;
+    }
+    t = (qx * dx + qy * dy) / lengthSq;
+    distance = std::fabs(qx * dy - qy * dx) / std::sqrt(lengthSq);
+}
+
+SegmentKind Bezier::classify(const CubicSegment& c, float tolerance) {
+    float d1, t1, d2, t2;
+    projectOnChord(c.p0, c.p3, c.p1, d1, t1);
+    projectOnChord(c.p0, c.p3, c.p2, d2, t2);
+    // Control points beyond the ends would make the curve overshoot or double back.
+    if (d1 <= tolerance && d2 <= tolerance && t1 >= 0.0f && t1 <= 1.0f && t2 >= 0.0f && t2 <= 1.0f) {
+        return SegmentKind::Line;
+    }
+    // The cubic term p3 - 3p2 + 3p1 - p0 moves the curve at most sqrt(3)/36 of its length
+    // away from the closest quadratic.
+    float ax = c.p3.x - 3.0f * c.p2.x + 3.0f * c.p1.x - c.p0.x;
+    float ay = c.p3.y - 3.0f * c.p2.y + 3.0f * c.p1.y - c.p0.y;
+    if (std::sqrt(ax * ax + ay * ay) * 0.048112522f <= tolerance) {
+        return SegmentKind::Quadratic;
+    }
+    return SegmentKind::Cubic;
+}
+
+int Bezier::uniformSubdivisions(const CubicSegment& c, float tolerance) {
+    float ax = c.p0.x - 2.0f * c.p1.x + c.p2.x, ay = c.p0.y - 2.0f * c.p1.y + c.p2.y;
+    float bx = c.p1.x - 2.0f * c.p2.x + c.p3.x, by = c.p1.y - 2.0f * c.p2.y + c.p3.y;
+    float m = std::sqrt(std::max(ax * ax + ay * ay, bx * bx + by * by));
+    if (tolerance <= 0.0f) {
+        return kMaxUniformSubdivisions;
+    }
+    // n = sqrt(3 * 2 / 8 * M / tol)
+    int n = (int)std::ceil(std::sqrt(0.75f * m / tolerance));
+    return std::clamp(n, 1, kMaxUniformSubdivisions);
+}
+
+void Bezier::flattenByKind(const CubicSegment& c, SegmentKind kind, float tolerance, std::vector<Point2>& out, bool includeStart) {
+    switch (kind) {
+        case SegmentKind::Line:
+            if (includeStart) {
+                out.push_back(c.p0);
+            }
+            out.push_back(c.p3);
+            break;
+        case SegmentKind::Quadratic: {
+            int n = uniformSubdivisions(c, tolerance);
+            for (int i = includeStart ? 0 : 1; i < n; i++) {
+                out.push_back(evaluate(c, 1.0f * i / n));
+            }
+            out.push_back(c.p3);
+            break;
+        }
+        case SegmentKind::Cubic:
+            flattenAdaptive(c, tolerance, out, includeStart);
+            break;
+    }
+}
+
+size_t Bezier::flattenByKindCount(const CubicSegment& c, SegmentKind kind, float tolerance, bool includeStart) {
+    size_t start = includeStart ? 1 : 0;
+    switch (kind) {
+        case SegmentKind::Line: return start + 1;
+        case SegmentKind::Quadratic: return start + (size_t)uniformSubdivisions(c, tolerance);
+        case SegmentKind::Cubic: return flattenAdaptiveCount(c, tolerance, includeStart);
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "bezier.h"
+#include <cstddef>
+
+// nanosvg stores every path command as a cubic, so straight edges of <rect>, <line>, <polygon>
+// and 'L' commands arrive as cubics with collinear control points.
+enum class SegmentKind {
+    Line,       // control points on the chord: the two end points are enough
+    Quadratic,  // negligible cubic term: analytic uniform subdivision
+    Cubic,      // everything else: recursive adaptive subdivision
+};
+
+struct SegmentStats {
+    size_t lines = 0;
+    size_t quadratics = 0;
+    size_t cubics = 0;
+
+    void add(SegmentKind kind);
+    size_t total() const { return lines + quadratics + cubics; }
+};
+
+namespace Bezier {
+    // Classification is relative to the flattening tolerance, in the same units as the points.
+    SegmentKind classify(const CubicSegment& c, float tolerance);
+
+    // Number of uniform pieces that keeps any cubic within `tolerance` of its polyline
+    // (Wang's formula). Cheap and tight for quadratic-like segments.
+    int uniformSubdivisions(const CubicSegment& c, float tolerance);
+
+    // Minimal polyline for a segment of the given kind; same includeStart convention as
+    // flattenAdaptive.
+    void flattenByKind(const CubicSegment& c, SegmentKind kind, float tolerance, std::vector<Point2>& out, bool includeStart = true);
+    // Exact number of points flattenByKind appends.
+    size_t flattenByKindCount(const CubicSegment& c, SegmentKind kind, float tolerance, bool includeStart = true);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Minimal float vector wrapper shared by the batch kernels. One backend is picked at compile
+// time: AVX2 (8 lanes, FMA when available), SSE2 or NEON (4 lanes), or plain float (1 lane)
+// so the same kernel code also builds for targets without SIMD. VecU holds kLanes uint32
+// values for kernels that keep packed integer data next to the floats.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_FLOAT_BACKEND "avx2"
+typedef __m256 VecF;
+typedef __m256 VecMask;
+static const size_t kLanes = 8;
+inline VecF vload(const float* p) { return _mm256_loadu_ps(p); }
+inline void vstore(float* p, VecF v) { _mm256_storeu_ps(p, v); }
+inline VecF vset(float f) { return _mm256_set1_ps(f); }
+inline VecF vadd(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+inline VecF vsub(VecF a, VecF b) { return _mm256_sub_ps(a, b); }
+inline VecF vmul(VecF a, VecF b) { return _mm256_mul_ps(a, b); }
+inline VecF vdiv(VecF a, VecF b) { return _mm256_div_ps(a, b); }
+inline VecF vmin(VecF a, VecF b) { return _mm256_min_ps(a, b); }
+inline VecF vmax(VecF a, VecF b) { return _mm256_max_ps(a, b); }
+inline VecF vsqrt(VecF a) { return _mm256_sqrt_ps(a); }
+#if defined(__FMA__)
+inline VecF vmadd(VecF a, VecF b, VecF c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+inline VecF vmadd(VecF a, VecF b, VecF c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+inline VecMask vless(VecF a, VecF b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline VecF vselect(VecMask m, VecF a, VecF b) { return _mm256_blendv_ps(b, a, m); }
+typedef __m256i VecU;
+inline VecU vloadu(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline void vstoreu(uint32_t* p, VecU v) { _mm256_storeu_si256((__m256i*)p, v); }
+inline VecU vsetu(uint32_t u) { return _mm256_set1_epi32((int)u); }
+inline VecF vlow16(VecU v) { return _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xffff))); }
+inline VecF vhigh16(VecU v) { return _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16)); }
+inline VecMask vequalu(VecU a, VecU b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+inline VecMask vandnot(VecMask a, VecMask b) { return _mm256_andnot_ps(a, b); }  // ~a & b
+inline VecU vselectu(VecMask m, VecU a, VecU b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m)); }
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_FLOAT_BACKEND "sse2"
+typedef __m128 VecF;
+typedef __m128 VecMask;
+static const size_t kLanes = 4;
+inline VecF vload(const float* p) { return _mm_loadu_ps(p); }
+inline void vstore(float* p, VecF v) { _mm_storeu_ps(p, v); }
+inline VecF vset(float f) { return _mm_set1_ps(f); }
+inline VecF vadd(VecF a, VecF b) { return _mm_add_ps(a, b); }
+inline VecF vsub(VecF a, VecF b) { return _mm_sub_ps(a, b); }
+inline VecF vmul(VecF a, VecF b) { return _mm_mul_ps(a, b); }
+inline VecF vdiv(VecF a, VecF b) { return _mm_div_ps(a, b); }
+inline VecF vmin(VecF a, VecF b) { return _mm_min_ps(a, b); }
+inline VecF vmax(VecF a, VecF b) { return _mm_max_ps(a, b); }
+inline VecF vsqrt(VecF a) { return _mm_sqrt_ps(a); }
+inline VecF vmadd(VecF a, VecF b, VecF c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline VecMask vless(VecF a, VecF b) { return _mm_cmplt_ps(a, b); }
+inline VecF vselect(VecMask m, VecF a, VecF b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+typedef __m128i VecU;
+inline VecU vloadu(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void vstoreu(uint32_t* p, VecU v) { _mm_storeu_si128((__m128i*)p, v); }
+inline VecU vsetu(uint32_t u) { return _mm_set1_epi32((int)u); }
+inline VecF vlow16(VecU v) { return _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xffff))); }
+inline VecF vhigh16(VecU v) { return _mm_cvtepi32_ps(_mm_srli_epi32(v, 16)); }
+inline VecMask vequalu(VecU a, VecU b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+inline VecMask vandnot(VecMask a, VecMask b) { return _mm_andnot_ps(a, b); }  // ~a & b
+inline VecU vselectu(VecMask m, VecU a, VecU b) { return _mm_castps_si128(vselect(m, _mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_FLOAT_BACKEND "neon"
+typedef float32x4_t VecF;
+typedef uint32x4_t VecMask;
+static const size_t kLanes = 4;
+inline VecF vload(const float* p) { return vld1q_f32(p); }
+inline void vstore(float* p, VecF v) { vst1q_f32(p, v); }
+inline VecF vset(float f) { return vdupq_n_f32(f); }
+inline VecF vadd(VecF a, VecF b) { return vaddq_f32(a, b); }
+inline VecF vsub(VecF a, VecF b) { return vsubq_f32(a, b); }
+inline VecF vmul(VecF a, VecF b) { return vmulq_f32(a, b); }
+inline VecF vdiv(VecF a, VecF b) { return vdivq_f32(a, b); }
+inline VecF vmin(VecF a, VecF b) { return vminq_f32(a, b); }
+inline VecF vmax(VecF a, VecF b) { return vmaxq_f32(a, b); }
+inline VecF vsqrt(VecF a) { return vsqrtq_f32(a); }
+inline VecF vmadd(VecF a, VecF b, VecF c) { return vfmaq_f32(c, a, b); }
+inline VecMask vless(VecF a, VecF b) { return vcltq_f32(a, b); }
+inline VecF vselect(VecMask m, VecF a, VecF b) { return vbslq_f32(m, a, b); }
+typedef uint32x4_t VecU;
+inline VecU vloadu(const uint32_t* p) { return vld1q_u32(p); }
+inline void vstoreu(uint32_t* p, VecU v) { vst1q_u32(p, v); }
+inline VecU vsetu(uint32_t u) { return vdupq_n_u32(u); }
+inline VecF vlow16(VecU v) { return vcvtq_f32_u32(vandq_u32(v, vdupq_n_u32(0xffff))); }
+inline VecF vhigh16(VecU v) { return vcvtq_f32_u32(vshrq_n_u32(v, 16)); }
+inline VecMask vequalu(VecU a, VecU b) { return vceqq_u32(a, b); }
+inline VecMask vandnot(VecMask a, VecMask b) { return vbicq_u32(b, a); }  // ~a & b
+inline VecU vselectu(VecMask m, VecU a, VecU b) { return vbslq_u32(m, a, b); }
+#else
+#include <cmath>
+#define SIMD_FLOAT_BACKEND "scalar"
+typedef float VecF;
+typedef bool VecMask;
+static const size_t kLanes = 1;
+inline VecF vload(const float* p) { return *p; }
+inline void vstore(float* p, VecF v) { *p = v; }
+inline VecF vset(float f) { return f; }
+inline VecF vadd(VecF a, VecF b) { return a + b; }
+inline VecF vsub(VecF a, VecF b) { return a - b; }
+inline VecF vmul(VecF a, VecF b) { return a * b; }
+inline VecF vdiv(VecF a, VecF b) { return a / b; }
+inline VecF vmin(VecF a, VecF b) { return a < b ? a : b; }
+inline VecF vmax(VecF a, VecF b) { return a > b ? a : b; }
+inline VecF vsqrt(VecF a) { return std::sqrt(a); }
+inline VecF vmadd(VecF a, VecF b, VecF c) { return a * b + c; }
+inline VecMask vless(VecF a, VecF b) { return a < b; }
+inline VecF vselect(VecMask m, VecF a, VecF b) { return m ? a : b; }
+typedef uint32_t VecU;
+inline VecU vloadu(const uint32_t* p) { return *p; }
+inline void vstoreu(uint32_t* p, VecU v) { *p = v; }
+inline VecU vsetu(uint32_t u) { return u; }
+inline VecF vlow16(VecU v) { return (float)(v & 0xffff); }
+inline VecF vhigh16(VecU v) { return (float)(v >> 16); }
+inline VecMask vequalu(VecU a, VecU b) { return a == b; }
+inline VecMask vandnot(VecMask a, VecMask b) { return !a && b; }
+inline VecU vselectu(VecMask m, VecU a, VecU b) { return m ? a : b; }
+#endif
@@ -0,0 +1,384 @@
+#include "stroke.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+static const float kPi = 3.14159265358979f;
+
+static Point2 add(Point2 a, Point2 b) { return { a.x + b.x, a.y + b.y }; }
+static Point2 subtract(Point2 a, Point2 b) { return { a.x - b.x, a.y - b.y }; }
+static Point2 scale(Point2 a, float s) { return { a.x * s, a.y * s }; }
+static float dot(Point2 a, Point2 b) { return a.x * b.x + a.y * b.y; }
+static float cross(Point2 a, Point2 b) { return a.x * b.y - a.y * b.x; }
+static bool equal(Point2 a, Point2 b) { return a.x == b.x && a.y == b.y; }
+// Left of `d`, NDC being y-up
+static Point2 perpendicular(Point2 d) { return { -d.y, d.x }; }
+
+static Point2 rotate(Point2 v, float angle) {
+    float c = std::cos(angle), s = std::sin(angle);
+    return { c * v.x - s * v.y, s * v.x + c * v.y };
+}
+
+// Unit vector from a to b; callers never pass equal points
+static Point2 direction(Point2 a, Point2 b) {
+    Point2 d = subtract(b, a);
+    return scale(d, 1.0f / std::sqrt(dot(d, d)));
+}
+
+// Drops zero-length edges in place, returns the new count
+static size_t removeDuplicates(Point2* points, size_t count) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (kept == 0 || !equal(points[i], points[kept - 1])) {
+            points[kept++] = points[i];
+        }
+    }
+    return kept;
+}
+
+// One path's stroke in NDC
+struct StrokeParams {
+    float halfWidth = 0.0f;
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Butt;
+    float miterLimit = 4.0f;
+    float maxArcStep = kPi;  // widest arc step of round joins and caps that stays within tolerance
+    const float* color = nullptr;
+};
+
+// Counts what a path emits, so the write pass can go straight into preallocated buffers.
+// Both sinks see exactly the same calls.
+struct StrokeCounter {
+    uint32_t vertexCount = 0;
+    size_t indexCount = 0;
+
+    uint32_t vertex(Point2) { return vertexCount++; }
+    void triangle(uint32_t, uint32_t, uint32_t) { indexCount += 3; }
+};
+
+template <typename Index>
+struct StrokeWriter {
+    MeshVertex* vertices;  // the path's first vertex
+    Index* indices;        // the path's first index
+    uint32_t firstVertex;
+    const float* color;
+    uint32_t vertexCount = 0;
+
+    uint32_t vertex(Point2 p) {
+        MeshVertex& v = vertices[vertexCount];
+        v.pos[0] = p.x;
+        v.pos[1] = p.y;
+        v.color[0] = color[0];
+        v.color[1] = color[1];
+        v.color[2] = color[2];
+        return vertexCount++;
+    }
+    void triangle(uint32_t a, uint32_t b, uint32_t c) {
+        *indices++ = (Index)(firstVertex + a);
+        *indices++ = (Index)(firstVertex + b);
+        *indices++ = (Index)(firstVertex + c);
+    }
+};
+
+// Triangle fan around `center` from center + from, turning by `sweep` radians (counterclockwise
+// if positive)
+template <typename Sink>
+static void fan(Sink& sink, const StrokeParams& p, Point2 center, Point2 from, float sweep) {
+    int steps = std::clamp((int)std::ceil(std::fabs(sweep) / p.maxArcStep), 1, 128);
+    uint32_t c = sink.vertex(center);
+    uint32_t previous = sink.vertex(add(center, from));
+    for (int k = 1; k <= steps; k++) {
+        uint32_t next = sink.vertex(add(center, rotate(from, sweep * k / steps)));
+        sink.triangle(c, previous, next);
+        previous = next;
+    }
+}
+
+// Fills the wedge on the outer side of the corner between edges with directions d0 and d1
+template <typename Sink>
+static void join(Sink& sink, const StrokeParams& p, Point2 at, Point2 d0, Point2 d1) {
+    float turn = cross(d0, d1);
+    float cosine = std::clamp(dot(d0, d1), -1.0f, 1.0f);
+    if (std::fabs(turn) < 1e-6f && cosine > 0.0f) {
+        return;
+    }
+    // The outer side is to the right of a left turn
+    float side = turn > 0.0f ? -1.0f : 1.0f;
+    Point2 n0 = scale(perpendicular(d0), side * p.halfWidth);
+    Point2 n1 = scale(perpendicular(d1), side * p.halfWidth);
+    if (p.join == LineJoin::Round) {
+        fan(sink, p, at, n0, (turn > 0.0f ? 1.0f : -1.0f) * std::acos(cosine));
+        return;
+    }
+    uint32_t center = sink.vertex(at);
+    uint32_t outer0 = sink.vertex(add(at, n0));
+    uint32_t outer1 = sink.vertex(add(at, n1));
+    // Miter length over stroke width is 1 / cos(turn / 2), and cos^2(turn / 2) = (1 + cos(turn)) / 2
+    if (p.join == LineJoin::Miter && 2.0f <= p.miterLimit * p.miterLimit * (1.0f + cosine)) {
+        uint32_t tip = sink.vertex(add(at, scale(add(n0, n1), 1.0f / (1.0f + cosine))));
+        sink.triangle(center, outer0, tip);
+        sink.triangle(center, tip, outer1);
+    } else {
+        sink.triangle(center, outer0, outer1);
+    }
+}
+
+// Cap at an open end; `d` points away from the line
+template <typename Sink>
+static void cap(Sink& sink, const StrokeParams& p, Point2 at, Point2 d) {
+    Point2 n = scale(perpendicular(d), p.halfWidth);
+    if (p.cap == LineCap::Round) {
+        fan(sink, p, at, n, -kPi);
+    } else if (p.cap == LineCap::Square) {
+        Point2 e = scale(d, p.halfWidth);
+        uint32_t a = sink.vertex(add(at, n));
+        uint32_t b = sink.vertex(subtract(at, n));
+        uint32_t c = sink.vertex(add(add(at, n), e));
+        uint32_t d2 = sink.vertex(add(subtract(at, n), e));
+        sink.triangle(a, b, c);
+        sink.triangle(c, b, d2);
+    }
+}
+
+// One quad per edge, a join at every corner, caps at open ends. `points` has no zero-length
+// edges; a closed polyline does not repeat its first point.
+template <typename Sink>
+static void strokePolyline(Sink& sink, const StrokeParams& p, const Point2* points, size_t count, bool closed) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1) {
+        // Zero-length subpath: only its caps show
+        if (p.cap == LineCap::Round) {
+            fan(sink, p, points[0], { p.halfWidth, 0.0f }, 2.0f * kPi);
+        } else if (p.cap == LineCap::Square) {
+            cap(sink, p, points[0], { 1.0f, 0.0f });
+            cap(sink, p, points[0], { -1.0f, 0.0f });
+        }
+        return;
+    }
+    size_t edges = closed ? count : count - 1;
+    Point2 first = {}, last = {};
+    for (size_t i = 0; i < edges; i++) {
+        Point2 a = points[i];
+        Point2 b = points[(i + 1) % count];
+        Point2 d = direction(a, b);
+        Point2 n = scale(perpendicular(d), p.halfWidth);
+        uint32_t v0 = sink.vertex(add(a, n));
+        uint32_t v1 = sink.vertex(subtract(a, n));
+        uint32_t v2 = sink.vertex(add(b, n));
+        uint32_t v3 = sink.vertex(subtract(b, n));
+        sink.triangle(v0, v1, v2);
+        sink.triangle(v2, v1, v3);
+        if (i > 0) {
+            join(sink, p, a, last, d);
+        } else {
+            first = d;
+        }
+        last = d;
+    }
+    if (closed) {
+        join(sink, p, points[0], last, first);
+    } else {
+        cap(sink, p, points[0], scale(first, -1.0f));
+        cap(sink, p, points[count - 1], last);
+    }
+}
+
+// Splits a polyline into its dashes, appended to `out` with their first point index in
+// `starts`. Odd dash lists repeat, as SVG specifies; the path's closing edge is dashed like
+// any other.
+static void dashPolyline(const std::vector<Point2>& points, bool closed, const StrokeStyle& style, float pixelScale,
+                         std::vector<Point2>& out, std::vector<size_t>& starts) {
+    const int count = style.dashCount;
+    const int cycle = count % 2 ? 2 * count : count;
+    auto dash = [&](int k) { return style.dashes[k % count] * pixelScale; };
+    float period = 0.0f;
+    for (int k = 0; k < cycle; k++) {
+        period += dash(k);
+    }
+    // Where in the pattern the path starts
+    float phase = std::fmod(style.dashOffset * pixelScale, period);
+    if (phase < 0.0f) {
+        phase += period;
+    }
+    int k = 0;
+    while (phase >= dash(k)) {
+        phase -= dash(k);
+        k = (k + 1) % cycle;
+    }
+    float remaining = dash(k) - phase;
+    bool on = k % 2 == 0;
+    if (on) {
+        starts.push_back(out.size());
+        out.push_back(points[0]);
+    }
+    size_t edges = closed ? points.size() : points.size() - 1;
+    for (size_t i = 0; i < edges; i++) {
+        Point2 a = points[i];
+        Point2 b = points[(i + 1) % points.size()];
+        Point2 ab = subtract(b, a);
+        float length = std::sqrt(dot(ab, ab));
+        float position = 0.0f;
+        while (length - position > remaining) {
+            position += remaining;
+            Point2 q = add(a, scale(ab, position / length));
+            if (on) {
+                out.push_back(q);
+            } else {
+                starts.push_back(out.size());
+                out.push_back(q);
+            }
+            on = !on;
+            k = (k + 1) % cycle;
+            remaining = dash(k);
+        }
+        remaining -= length - position;
+        if (on) {
+            out.push_back(b);
+        }
+    }
+}
+
+static bool isDashed(const StrokeStyle& style) {
+    float period = 0.0f;
+    for (int k = 0; k < style.dashCount; k++) {
+        if (!(style.dashes[k] >= 0.0f)) {
+            return false;  // invalid lists draw solid
+        }
+        period += style.dashes[k];
+    }
+    return period > 0.0f;
+}
+
+// Per chunk buffers, reused by every path of the chunk
+struct StrokeScratch {
+    std::vector<Point2> points;
+    std::vector<Point2> dashes;
+    std::vector<size_t> dashStarts;
+};
+
+StrokeMesh StrokeMesh::build(const SvgSegments& svg, const SvgStyles& styles, const TessellationOptions& options) {
+    StrokeMesh mesh;
+    mesh.key.options = options;
+    const size_t segmentCount = svg.size();
+    float div = std::max(svg.width, svg.height);
+
+    // NDC spans 2 units across the viewport, and the SVG's larger side spans 2 units of NDC
+    float tolerance = 2.0f * options.tolerancePixels / options.viewportPixels;
+    float pixelScale = 2.0f / div;
+
+    // Segments of a path are consecutive
+    std::vector<size_t> pathStarts;
+    for (size_t i = 0; i < segmentCount; i++) {
+        if (i == 0 || svg.pathIds[i] != svg.pathIds[i - 1]) {
+            pathStarts.push_back(i);
+        }
+    }
+    const size_t pathCount = pathStarts.size();
+    pathStarts.push_back(segmentCount);
+
+    auto styleOf = [&](size_t path) -> const StrokeStyle* {
+        size_t shape = (size_t)svg.shapeIds[pathStarts[path]];
+        return shape < styles.strokes.size() && styles.strokes[shape].width > 0.0f ? &styles.strokes[shape] : nullptr;
+    };
+
+    // Flattens path `path` and strokes it, dash by dash, into `sink`
+    auto strokePath = [&](size_t path, auto& sink, StrokeScratch& scratch) {
+        const StrokeStyle* style = styleOf(path);
+        if (!style) {
+            return;
+        }
+        StrokeParams p;
+        p.halfWidth = 0.5f * style->width * pixelScale;
+        p.join = style->join;
+        p.cap = style->cap;
+        p.miterLimit = style->miterLimit;
+        // A chord of angle a sags halfWidth * (1 - cos(a / 2)) below its arc
+        if (tolerance < p.halfWidth) {
+            p.maxArcStep = 2.0f * std::acos(1.0f - tolerance / p.halfWidth);
+        }
+        p.color = style->color;
+
+        std::vector<Point2>& points = scratch.points;
+        points.clear();
+        svg.flattenPath(pathStarts[path], pathStarts[path + 1], div, tolerance, points);
+        points.resize(removeDuplicates(points.data(), points.size()));
+        size_t pathId = (size_t)svg.pathIds[pathStarts[path]];
+        bool closed = pathId < styles.closedPaths.size() && styles.closedPaths[pathId];
+        if (closed && points.size() > 1 && equal(points.front(), points.back())) {
+            points.pop_back();
+        }
+        if (points.size() < 2 || !isDashed(*style)) {
+            strokePolyline(sink, p, points.data(), points.size(), closed);
+            return;
+        }
+        scratch.dashes.clear();
+        scratch.dashStarts.clear();
+        dashPolyline(points, closed, *style, pixelScale, scratch.dashes, scratch.dashStarts);
+        scratch.dashStarts.push_back(scratch.dashes.size());
+        for (size_t d = 0; d + 1 < scratch.dashStarts.size(); d++) {
+            Point2* dash = &scratch.dashes[scratch.dashStarts[d]];
+            strokePolyline(sink, p, dash, removeDuplicates(dash, scratch.dashStarts[d + 1] - scratch.dashStarts[d]), false);
+        }
+    };
+
+    // Pass 1: count every path's vertices and indices
+    std::vector<uint32_t> vertexCounts(pathCount, 0);
+    std::vector<size_t> indexCounts(pathCount, 0);
+    Parallel::forRange(pathCount, [&](size_t begin, size_t end) {
+        StrokeScratch scratch;
+        for (size_t path = begin; path < end; path++) {
+            StrokeCounter counter;
+            strokePath(path, counter, scratch);
+            vertexCounts[path] = counter.vertexCount;
+            indexCounts[path] = counter.indexCount;
+        }
+    }, 64);
+
+    // Prefix sums: where each path's vertices and indices start
+    std::vector<size_t> firstVertices(pathCount, 0);
+    size_t vertexCount = 0, indexCount = 0;
+    mesh.ranges.resize(pathCount);
+    for (size_t path = 0; path < pathCount; path++) {
+        MeshRange& range = mesh.ranges[path];
+        range.firstIndex = (uint32_t)indexCount;
+        range.indexCount = (uint32_t)indexCounts[path];
+        range.shapeId = svg.shapeIds[pathStarts[path]];
+        range.pathId = svg.pathIds[pathStarts[path]];
+        firstVertices[path] = vertexCount;
+        vertexCount += vertexCounts[path];
+        indexCount += indexCounts[path];
+    }
+
+    // Pass 2: every path writes at its offsets, in parallel, into buffers allocated once
+    mesh.vertices.resize(vertexCount);
+    auto write = [&](auto* indices) {
+        using Index = std::remove_pointer_t<decltype(indices)>;
+        Parallel::forRange(pathCount, [&](size_t begin, size_t end) {
+            StrokeScratch scratch;
+            for (size_t path = begin; path < end; path++) {
+                MeshRange& range = mesh.ranges[path];
+                StrokeWriter<Index> writer = { &mesh.vertices[firstVertices[path]], indices + range.firstIndex,
+                                               (uint32_t)firstVertices[path], nullptr };
+                if (const StrokeStyle* style = styleOf(path)) {
+                    writer.color = style->color;
+                }
+                strokePath(path, writer, scratch);
+                for (uint32_t v = 0; v < writer.vertexCount; v++) {
+                    const MeshVertex& vertex = writer.vertices[v];
+                    range.bounds.expand(Point2{ vertex.pos[0], vertex.pos[1] });
+                }
+            }
+        }, 64);
+    };
+    if (mesh.indexType() == MeshIndexType::UInt16) {
+        mesh.indices16.resize(indexCount);
+        write(mesh.indices16.data());
+    } else {
+        mesh.indices32.resize(indexCount);
+        write(mesh.indices32.data());
+    }
+    return mesh;
+}
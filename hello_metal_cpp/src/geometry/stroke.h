@@ -0,0 +1,28 @@
+#pragma once
+#include "svg_mesh.h"
+#include "svg_styles.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Identifies a stroke mesh in the curve cache. Bump version whenever StrokeMesh::build's
+// output changes for the same segments, styles and options.
+struct StrokeCacheKey {
+    uint32_t version = 2;
+    uint32_t vertexSize = sizeof(MeshVertex);
+    TessellationOptions options;
+};
+
+// Stroked outlines as an indexed triangle list: every path flattened adaptively, expanded to
+// its shape's stroke width with joins, caps and dashes, in the stroke color. Same vertex
+// layout as SvgMesh, so it draws with the general pipeline as PrimitiveTypeTriangle.
+// Ranges are one per path; unstroked paths have no indices.
+// cacheBlobs() are the blobs to pass to CurveCache::update, or as SvgMesh::writeCache's
+// extraBlobs.
+struct StrokeMesh : CachedMesh<StrokeCacheKey, kStrokeMeshTag> {
+    // Segments in pixels, as parsed; `styles` from the same image. Paths are counted, then
+    // written into one allocation, both passes in parallel across paths.
+    static StrokeMesh build(const SvgSegments& svg, const SvgStyles& styles,
+                            const TessellationOptions& options = TessellationOptions());
+};
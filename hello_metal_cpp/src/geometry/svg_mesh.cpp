@@ -0,0 +1,266 @@
+#include "svg_mesh.h"
+#include "arc_length.h"
+#include "bezier_batch.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static MeshVertex makeVertex(float x, float y, float r, float g, float b) {
+    MeshVertex v;
+    v.pos[0] = x;
+    v.pos[1] = y;
+    v.color[0] = r;
+    v.color[1] = g;
+    v.color[2] = b;
+    return v;
+}
+
+static MeshVertex* writePoints(const std::vector<Point2>& points, MeshVertex* out) {
+    for (const Point2& point : points) {
+        *out++ = makeVertex(point.x, point.y, 0.0f, 0.0f, 0.0f);
+    }
+    return out;
+}
+
+// Vertices each segment's normal band adds, drawn as one closed strip
+static size_t normalBandVertices(int samples) {
+    return 2 * (size_t)samples + 1;
+}
+
+// Red band normalLength to either side of segment s of `frames`: the offset points on the
+// positive side backwards, the negative side forwards, then closed. With two samples this is
+// the quad across the curve at both end points.
+static void writeNormalBand(const CurveFrames& frames, size_t s, float normalLength, MeshVertex* out) {
+    const size_t samples = frames.sampleCount;
+    for (size_t k = samples; k-- > 0;) {
+        size_t i = frames.index(s, k);
+        *out++ = makeVertex(frames.offsetX[i], frames.offsetY[i], 1.0f, 0.0f, 0.0f);
+    }
+    for (size_t k = 0; k < samples; k++) {
+        size_t i = frames.index(s, k);
+        *out++ = makeVertex(frames.x[i] - normalLength * frames.normalX[i], frames.y[i] - normalLength * frames.normalY[i], 1.0f, 0.0f, 0.0f);
+    }
+    size_t last = frames.index(s, samples - 1);
+    *out = makeVertex(frames.offsetX[last], frames.offsetY[last], 1.0f, 0.0f, 0.0f);
+}
+
+// Segments [firstSegment, firstSegment + segmentCount) of one path and where its vertices go:
+// the path's line strip first, then one normal band per segment
+struct PathSpan {
+    size_t firstSegment = 0;
+    size_t segmentCount = 0;
+    size_t firstVertex = 0;
+    size_t stripVertices = 0;
+    size_t bandVertices = 0;  // per segment
+};
+
+static size_t pathIndexCount(const PathSpan& path) {
+    return path.stripVertices + 1 + path.segmentCount * (path.bandVertices + 1);
+}
+
+// Every vertex of a path is consecutive, so each strip is a run of consecutive indices
+template <typename Index>
+static Index* writePathIndices(const PathSpan& path, Index* out) {
+    const Index restart = std::numeric_limits<Index>::max();
+    Index index = (Index)path.firstVertex;
+    for (size_t k = 0; k < path.stripVertices; k++) {
+        *out++ = index++;
+    }
+    *out++ = restart;
+    for (size_t segment = 0; segment < path.segmentCount; segment++) {
+        for (size_t k = 0; k < path.bandVertices; k++) {
+            *out++ = index++;
+        }
+        *out++ = restart;
+    }
+    return out;
+}
+
+template <typename Index>
+static void writeIndices(const std::vector<PathSpan>& paths, const std::vector<MeshRange>& ranges, Index* out) {
+    Parallel::forRange(paths.size(), [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++) {
+            writePathIndices(paths[p], out + ranges[p].firstIndex);
+        }
+    }, 256);
+}
+
+SvgMesh SvgMesh::build(const SvgSegments& svg, const TessellationOptions& options) {
+    SvgMesh mesh;
+    mesh.key.options = options;
+    const size_t segmentCount = svg.size();
+    float div = std::max(svg.width, svg.height);
+
+    // NDC spans 2 units across the viewport
+    float tolerance = 2.0f * options.tolerancePixels / options.viewportPixels;
+    float arcSpacing = 2.0f * options.arcSpacingPixels / options.viewportPixels;
+    const int uniformSamples = 501;
+    const int bandSamples = std::max(options.normalSamples, 2);
+
+    auto toNDC = [div](CubicSegment segment) {
+        for (Point2* point : { &segment.p0, &segment.p1, &segment.p2, &segment.p3 }) {
+            point->x = 2 * (point->x / div) - 1.0f;
+            point->y = 1.0f - 2 * (point->y / div);
+        }
+        return segment;
+    };
+    // Uniform mode only samples curved segments; straight ones take the adaptive path
+    auto sampledUniformly = [&](SegmentKind kind) {
+        return options.mode == TessellationMode::Uniform && kind != SegmentKind::Line;
+    };
+    // Segments of a path are consecutive and share their end points, so only the first
+    // segment of each path writes its start point
+    auto startsPath = [&](size_t i) {
+        return i == 0 || svg.pathIds[i] != svg.pathIds[i - 1];
+    };
+
+    // Pass 1: classify every segment and count the strip vertices it will write. Straight
+    // edges become a single line in every mode but ArcLength.
+    std::vector<SegmentKind> kinds(segmentCount);
+    std::vector<size_t> offsets(segmentCount, 0);
+    Parallel::forRange(segmentCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            // pts are in pixels, tolerance in NDC
+            kinds[i] = Bezier::classify(svg.get(i), tolerance * div / 2);
+            CubicSegment segment = toNDC(svg.get(i));
+            bool includeStart = startsPath(i);
+            size_t count;
+            if (options.mode == TessellationMode::ArcLength) {
+                count = ArcLengthSegment(segment).sampleEveryCount(arcSpacing, includeStart);
+            } else if (sampledUniformly(kinds[i])) {
+                count = uniformSamples - (includeStart ? 0 : 1);
+            } else {
+                count = Bezier::flattenByKindCount(segment, kinds[i], tolerance, includeStart);
+            }
+            offsets[i] = count;
+        }
+    });
+
+    // Prefix sums: each path takes its strip vertices, then its normal bands. offsets[i]
+    // becomes where segment i's strip vertices start, bandOffsets[i] where its band does.
+    std::vector<size_t> bandOffsets(segmentCount, 0);
+    std::vector<size_t> batchIds(segmentCount, 0);
+    std::vector<PathSpan> paths;
+    size_t vertexCount = 0, indexCount = 0, curved = 0;
+    for (size_t first = 0; first < segmentCount;) {
+        PathSpan path;
+        path.firstSegment = first;
+        path.firstVertex = vertexCount;
+        size_t end = first + 1;
+        while (end < segmentCount && !startsPath(end)) {
+            end++;
+        }
+        for (size_t i = first; i < end; i++) {
+            mesh.stats.add(kinds[i]);
+            size_t count = offsets[i];
+            offsets[i] = vertexCount;
+            vertexCount += count;
+            batchIds[i] = curved;
+            curved += sampledUniformly(kinds[i]) ? 1 : 0;
+        }
+        path.segmentCount = end - first;
+        path.stripVertices = vertexCount - path.firstVertex;
+        path.bandVertices = normalBandVertices(bandSamples);
+        for (size_t i = first; i < end; i++) {
+            bandOffsets[i] = vertexCount;
+            vertexCount += path.bandVertices;
+        }
+
+        MeshRange range;
+        range.firstIndex = (uint32_t)indexCount;
+        range.indexCount = (uint32_t)pathIndexCount(path);
+        range.shapeId = svg.shapeIds[first];
+        range.pathId = svg.pathIds[first];
+        indexCount += range.indexCount;
+        mesh.ranges.push_back(range);
+        paths.push_back(path);
+        first = end;
+    }
+
+    // Uniform mode: evaluate every curved segment of the image in one batch, 0.002 step in t
+    CubicSegmentsSoA segments;
+    std::vector<float> sampleX, sampleY;
+    if (curved > 0) {
+        segments.reserve(curved);
+        for (size_t i = 0; i < segmentCount; i++) {
+            if (sampledUniformly(kinds[i])) {
+                segments.push(toNDC(svg.get(i)));
+            }
+        }
+        sampleX.resize(curved * uniformSamples);
+        sampleY.resize(curved * uniformSamples);
+        Bezier::evaluateBatch(segments, BezierBasis::uniform(uniformSamples), sampleX, sampleY);
+    }
+
+    // Pass 2: every segment writes its vertices at its offsets, so chunks run independently
+    // and the output is allocated exactly once
+    mesh.vertices.resize(vertexCount);
+    const BezierBasis bandBasis = BezierBasis::uniform(bandSamples);
+    Parallel::forRange(segmentCount, [&](size_t begin, size_t end) {
+        std::vector<Point2> points;  // reused by every segment of the chunk
+        CubicSegmentsSoA block;
+        CurveFrames frames;
+        for (size_t i = begin; i < end; i++) {
+            CubicSegment segment = toNDC(svg.get(i));
+            bool includeStart = startsPath(i);
+            MeshVertex* out = &mesh.vertices[offsets[i]];
+            points.clear();
+            if (options.mode == TessellationMode::ArcLength) {
+                ArcLengthSegment(segment).sampleEvery(arcSpacing, points, includeStart);
+                writePoints(points, out);
+            } else if (sampledUniformly(kinds[i])) {
+                const float* xs = &sampleX[batchIds[i] * uniformSamples];
+                const float* ys = &sampleY[batchIds[i] * uniformSamples];
+                for (int k = includeStart ? 0 : 1; k < uniformSamples; k++) {
+                    *out++ = makeVertex(xs[k], ys[k], 0.0f, 0.0f, 0.0f);
+                }
+            } else {
+                Bezier::flattenByKind(segment, kinds[i], tolerance, points, includeStart);
+                writePoints(points, out);
+            }
+        }
+
+        // Normal bands a block of segments at a time, so the frames stay small
+        const size_t kBandBlock = 1024;
+        block.reserve(kBandBlock);
+        for (size_t first = begin; first < end; first += kBandBlock) {
+            size_t last = std::min(first + kBandBlock, end);
+            block.clear();
+            for (size_t i = first; i < last; i++) {
+                block.push(toNDC(svg.get(i)));
+            }
+            Bezier::evaluateFrames(block, bandBasis, options.normalLength, frames);
+            for (size_t i = first; i < last; i++) {
+                writeNormalBand(frames, i - first, options.normalLength, &mesh.vertices[bandOffsets[i]]);
+            }
+        }
+    }, 256);
+
+    // Path bounds, for culling
+    Parallel::forRange(paths.size(), [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++) {
+            size_t last = p + 1 < paths.size() ? paths[p + 1].firstVertex : vertexCount;
+            for (size_t v = paths[p].firstVertex; v < last; v++) {
+                mesh.ranges[p].bounds.expand(Point2{ mesh.vertices[v].pos[0], mesh.vertices[v].pos[1] });
+            }
+        }
+    }, 256);
+
+    // Indices go straight into the final width
+    if (mesh.indexType() == MeshIndexType::UInt16) {
+        mesh.indices16.resize(indexCount);
+        writeIndices(paths, mesh.ranges, mesh.indices16.data());
+    } else {
+        mesh.indices32.resize(indexCount);
+        writeIndices(paths, mesh.ranges, mesh.indices32.data());
+    }
+    return mesh;
+}
+
+bool SvgMesh::writeCache(const char* cachePath, uint64_t sourceHash, const SvgSegments& svg,
+                         std::span<const CurveCache::Blob> extraBlobs) const {
+    std::vector<CurveCache::Blob> blobs = cacheBlobs();
+    blobs.insert(blobs.end(), extraBlobs.begin(), extraBlobs.end());
+    return CurveCache::update(cachePath, sourceHash, svg, blobs);
+}
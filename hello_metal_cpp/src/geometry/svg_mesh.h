@@ -0,0 +1,76 @@
+#pragma once
+#include "curve_cache.h"
+#include "indexed_mesh.h"
+#include "segment_classify.h"
+#include "svg_segments.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class TessellationMode {
+    Adaptive,   // as few vertices as tolerancePixels allows
+    Uniform,    // fixed 0.002 step in t, 501 vertices per curved segment
+    ArcLength,  // a vertex every arcSpacingPixels along the curve, e.g. for even Voronoi seeding
+};
+
+// How buildSVG turns each cubic into line vertices.
+struct TessellationOptions {
+    TessellationMode mode = TessellationMode::Adaptive;
+    float tolerancePixels = 0.25f;  // max deviation from the true curve, in screen pixels
+    float arcSpacingPixels = 4.0f;  // distance between vertices in ArcLength mode
+    float viewportPixels = 600.0f;  // pixels covered by the [-1, 1] NDC range
+    float normalLength = 0.1f;      // how far the normal bands reach to either side, in NDC
+    int normalSamples = 2;          // points per segment along each band; 2 draws end point quads
+};
+
+// Metal-free vertex descriptor: one entry per shader attribute, turned into an
+// MTL::VertexDescriptor by the renderer.
+enum class VertexAttributeFormat {
+    Float2,
+    Float3,
+    UShort2Normalized,  // read as float2 in [0, 1]
+    UShort,
+};
+
+struct VertexAttribute {
+    VertexAttributeFormat format;
+    uint32_t offset;
+};
+
+struct VertexLayout {
+    VertexAttribute position;  // attribute(0)
+    VertexAttribute color;     // attribute(1)
+    uint32_t stride;
+};
+
+static constexpr VertexLayout kMeshVertexLayout = {
+    { VertexAttributeFormat::Float2, 0 },
+    { VertexAttributeFormat::Float3, offsetof(MeshVertex, color) },
+    sizeof(MeshVertex),
+};
+
+// Identifies a line mesh in the curve cache. Bump version whenever SvgMesh::build's output
+// changes for the same segments and options.
+struct MeshCacheKey {
+    uint32_t version = 4;
+    uint32_t vertexSize = sizeof(MeshVertex);
+    TessellationOptions options;
+};
+
+// CPU half of MeshFactory::buildSVG: every path flattened into one NDC line strip, the normal
+// quads at both ends of each segment, and the indices that draw them as line strips. Ranges
+// are one per path, in segment order.
+struct SvgMesh : CachedMesh<MeshCacheKey, kLineMeshTag> {
+    SegmentStats stats;
+
+    // Segments in pixels, as parsed; both axes are divided by max(width, height).
+    static SvgMesh build(const SvgSegments& svg, const TessellationOptions& options = TessellationOptions());
+
+    // Meshes live in the curve cache as blobs, keyed by the options that produced them;
+    // findCached (from CachedMesh) looks one up. writeCache writes the segments, this mesh
+    // and `extraBlobs` (e.g. a StrokeMesh's) to `cachePath`, keeping the other meshes of a
+    // cache already there (CurveCache::update).
+    bool writeCache(const char* cachePath, uint64_t sourceHash, const SvgSegments& svg,
+                    std::span<const CurveCache::Blob> extraBlobs = {}) const;
+};
@@ -0,0 +1,153 @@
+#include "svg_segments.h"
+#include "parallel.h"
+#include "segment_classify.h"
+#include <algorithm>
+
+SvgSegments SvgSegments::fromImage(const NSVGimage* image) {
+    SvgSegments result;
+    if (!image) {
+        return result;
+    }
+    result.width = image->width;
+    result.height = image->height;
+    int shapeId = 0, pathId = 0;
+    for (NSVGshape* shape = image->shapes; shape != nullptr; shape = shape->next, shapeId++) {
+        for (NSVGpath* path = shape->paths; path != nullptr; path = path->next, pathId++) {
+            for (int i = 0; i < path->npts - 1; i += 3) {
+                result.curves.push(Bezier::fromPoints(&path->pts[i * 2]));
+                result.shapeIds.push_back(shapeId);
+                result.pathIds.push_back(pathId);
+            }
+        }
+    }
+    return result;
+}
+
+// Appends paths as nanosvg decodes them. NSVGshape::paths is a prepend list, so at the end
+// of each shape its paths are put back into that order: the shape's segments are reversed
+// as a whole, then each path's segments are reversed again.
+struct StreamSink {
+    SvgSegments& out;
+    std::vector<size_t> pathEnds = {};  // segment count after each path of the current shape
+    size_t shapeBegin = 0;
+    int shapeId = 0;
+
+    static void path(void* ud, const float* pts, int npts, char) {
+        StreamSink& sink = *static_cast<StreamSink*>(ud);
+        for (int i = 0; i < npts - 1; i += 3) {
+            sink.out.curves.push(Bezier::fromPoints(&pts[i * 2]));
+        }
+        sink.pathEnds.push_back(sink.out.size());
+    }
+
+    static void shapeEnd(void* ud) {
+        StreamSink& sink = *static_cast<StreamSink*>(ud);
+        SvgSegments& out = sink.out;
+        const size_t begin = sink.shapeBegin, end = out.size();
+        const int firstPath = out.pathIds.empty() ? 0 : out.pathIds.back() + 1;
+        const int pathCount = (int)sink.pathEnds.size();
+        CubicSegmentsSoA& c = out.curves;
+        for (std::vector<float>* v : { &c.x0, &c.y0, &c.x1, &c.y1, &c.x2, &c.y2, &c.x3, &c.y3 }) {
+            std::reverse(v->begin() + begin, v->begin() + end);
+            // Path p now starts where the paths after it used to end
+            for (int p = 0; p < pathCount; p++) {
+                size_t pathBegin = begin + (end - sink.pathEnds[p]);
+                size_t length = sink.pathEnds[p] - (p > 0 ? sink.pathEnds[p - 1] : begin);
+                std::reverse(v->begin() + pathBegin, v->begin() + pathBegin + length);
+            }
+        }
+        for (int p = pathCount - 1; p >= 0; p--) {
+            size_t length = sink.pathEnds[p] - (p > 0 ? sink.pathEnds[p - 1] : begin);
+            out.shapeIds.insert(out.shapeIds.end(), length, sink.shapeId);
+            out.pathIds.insert(out.pathIds.end(), length, firstPath + (pathCount - 1 - p));
+        }
+        sink.pathEnds.clear();
+        sink.shapeBegin = end;
+        sink.shapeId++;
+    }
+};
+
+static void finishStream(SvgSegments& result, const float* view) {
+    // Paths not followed by a shape are dropped, as nsvgParse does
+    CubicSegmentsSoA& c = result.curves;
+    std::vector<std::vector<float>*> xs = { &c.x0, &c.x1, &c.x2, &c.x3 }, ys = { &c.y0, &c.y1, &c.y2, &c.y3 };
+    // The viewBox mapping nsvgParse applies to every point, with the same rounding
+    for (std::vector<float>* v : xs) {
+        v->resize(result.shapeIds.size());
+        for (float& x : *v) {
+            x = (x + view[0]) * view[2];
+        }
+    }
+    for (std::vector<float>* v : ys) {
+        v->resize(result.shapeIds.size());
+        for (float& y : *v) {
+            y = (y + view[1]) * view[3];
+        }
+    }
+    result.width = view[4];
+    result.height = view[5];
+}
+
+SvgSegments SvgSegments::parse(char* input, const char* units, float dpi) {
+    SvgSegments result;
+    StreamSink stream{ result };
+    NSVGgeometrySink sink = { StreamSink::path, StreamSink::shapeEnd, &stream };
+    float view[6];
+    if (nsvgParseGeometry(input, units, dpi, &sink, view)) {
+        finishStream(result, view);
+    }
+    return result;
+}
+
+SvgSegments SvgSegments::fromFile(const char* path, const char* units, float dpi) {
+    SvgSegments result;
+    StreamSink stream{ result };
+    NSVGgeometrySink sink = { StreamSink::path, StreamSink::shapeEnd, &stream };
+    float view[6];
+    if (nsvgParseGeometryFromFile(path, units, dpi, &sink, view)) {
+        finishStream(result, view);
+    }
+    return result;
+}
+
+// NSVGparallelFor on top of Parallel::forRange; nanosvg sizes the chunks by source bytes
+static void parallelFor(void*, int count, void (*job)(void* jobUd, int index), void* jobUd) {
+    Parallel::forRange((size_t)count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            job(jobUd, (int)i);
+        }
+    }, 1);
+}
+
+SvgSegments SvgSegments::parseParallel(char* input, const char* units, float dpi) {
+    NSVGimage* image = nsvgParseParallel(input, units, dpi, parallelFor, nullptr);
+    SvgSegments result = fromImage(image);
+    nsvgDelete(image);
+    return result;
+}
+
+void SvgSegments::toNDC(float div) {
+    for (std::vector<float>* xs : { &curves.x0, &curves.x1, &curves.x2, &curves.x3 }) {
+        for (float& x : *xs) {
+            x = 2 * (x / div) - 1.0f;
+        }
+    }
+    for (std::vector<float>* ys : { &curves.y0, &curves.y1, &curves.y2, &curves.y3 }) {
+        for (float& y : *ys) {
+            y = 1.0f - 2 * (y / div);
+        }
+    }
+}
+
+void SvgSegments::flattenPath(size_t begin, size_t end, float div, float tolerance, std::vector<Point2>& out) const {
+    for (size_t i = begin; i < end; i++) {
+        // pts are in pixels, tolerance in NDC
+        CubicSegment segment = get(i);
+        SegmentKind kind = Bezier::classify(segment, tolerance * div / 2);
+        for (Point2* point : { &segment.p0, &segment.p1, &segment.p2, &segment.p3 }) {
+            point->x = 2 * (point->x / div) - 1.0f;
+            point->y = 1.0f - 2 * (point->y / div);
+        }
+        Bezier::flattenByKind(segment, kind, tolerance, out, i == begin);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "bezier_batch.h"
+#include "nanosvg.h"
+#include <vector>
+
+// Every cubic of an NSVGimage in one flat block, in shape -> path -> pts order, with the
+// shape and path each segment came from.
+struct SvgSegments {
+    CubicSegmentsSoA curves;
+    std::vector<int> shapeIds;  // index of the shape in image->shapes
+    std::vector<int> pathIds;   // index of the path across the whole image
+    float width = 0.0f;         // image size, as NSVGimage::width / height
+    float height = 0.0f;
+
+    size_t size() const { return curves.size(); }
+    CubicSegment get(size_t i) const { return curves.get(i); }
+
+    static SvgSegments fromImage(const NSVGimage* image);
+    // Geometry-only parse straight into the flat arrays: no NSVGimage, shapes, paints or
+    // per-path allocations. Same segments, ids and order as fromImage(nsvgParse(...)).
+    // parse changes `input`; fromFile returns an empty result if the file cannot be read.
+    static SvgSegments parse(char* input, const char* units = "px", float dpi = 96.0f);
+    static SvgSegments fromFile(const char* path, const char* units = "px", float dpi = 96.0f);
+    // nsvgParseParallel across all cores, then fromImage. For single documents with very many
+    // shape elements; the result is identical to fromImage(nsvgParse(...)). Changes `input`.
+    static SvgSegments parseParallel(char* input, const char* units = "px", float dpi = 96.0f);
+    // Same mapping buildSVG applies: pixels -> [-1, 1], y up, both axes divided by `div`.
+    void toNDC(float div);
+    // Segments [begin, end) of one path mapped the same way and flattened by kind within
+    // `tolerance` (NDC), as SvgMesh's Adaptive mode does. The segments share their joints, so
+    // each appears once.
+    void flattenPath(size_t begin, size_t end, float div, float tolerance, std::vector<Point2>& out) const;
+};
@@ -0,0 +1,61 @@
+#include "svg_styles.h"
+#include <algorithm>
+
+// NSVGpaint colors are 0xAABBGGRR
+static void unpackColor(unsigned int color, float* rgb) {
+    rgb[0] = (color & 0xFF) / 255.0f;
+    rgb[1] = ((color >> 8) & 0xFF) / 255.0f;
+    rgb[2] = ((color >> 16) & 0xFF) / 255.0f;
+}
+
+// Gradients are drawn in their first stop's color
+static void paintColor(const NSVGpaint& paint, float* rgb) {
+    if (paint.type == NSVG_PAINT_COLOR) {
+        unpackColor(paint.color, rgb);
+    } else if (paint.gradient && paint.gradient->nstops > 0) {
+        unpackColor(paint.gradient->stops[0].color, rgb);
+    }
+}
+
+static StrokeStyle strokeStyle(const NSVGshape* shape) {
+    StrokeStyle style;
+    if (!(shape->flags & NSVG_FLAGS_VISIBLE) || shape->stroke.type == NSVG_PAINT_NONE || !(shape->strokeWidth > 0.0f)) {
+        return style;
+    }
+    style.width = shape->strokeWidth;
+    style.join = (LineJoin)shape->strokeLineJoin;
+    style.cap = (LineCap)shape->strokeLineCap;
+    style.miterLimit = shape->miterLimit;
+    style.dashOffset = shape->strokeDashOffset;
+    style.dashCount = std::clamp((int)shape->strokeDashCount, 0, 8);
+    std::copy(shape->strokeDashArray, shape->strokeDashArray + style.dashCount, style.dashes);
+    paintColor(shape->stroke, style.color);
+    return style;
+}
+
+static FillStyle fillStyle(const NSVGshape* shape) {
+    FillStyle style;
+    if (!(shape->flags & NSVG_FLAGS_VISIBLE) || shape->fill.type == NSVG_PAINT_NONE) {
+        return style;
+    }
+    style.filled = true;
+    style.rule = (FillRule)shape->fillRule;
+    paintColor(shape->fill, style.color);
+    return style;
+}
+
+SvgStyles SvgStyles::fromImage(const NSVGimage* image) {
+    SvgStyles result;
+    if (!image) {
+        return result;
+    }
+    // Same walk as SvgSegments::fromImage, so the ids line up
+    for (NSVGshape* shape = image->shapes; shape != nullptr; shape = shape->next) {
+        result.strokes.push_back(strokeStyle(shape));
+        result.fills.push_back(fillStyle(shape));
+        for (NSVGpath* path = shape->paths; path != nullptr; path = path->next) {
+            result.closedPaths.push_back((uint8_t)path->closed);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "nanosvg.h"
+#include <cstdint>
+#include <vector>
+
+// Values match NSVGlineJoin / NSVGlineCap / NSVGfillRule.
+enum class LineJoin : uint8_t {
+    Miter = NSVG_JOIN_MITER,
+    Round = NSVG_JOIN_ROUND,
+    Bevel = NSVG_JOIN_BEVEL,
+};
+
+enum class LineCap : uint8_t {
+    Butt = NSVG_CAP_BUTT,
+    Round = NSVG_CAP_ROUND,
+    Square = NSVG_CAP_SQUARE,
+};
+
+enum class FillRule : uint8_t {
+    NonZero = NSVG_FILLRULE_NONZERO,
+    EvenOdd = NSVG_FILLRULE_EVENODD,
+};
+
+// Stroke of one NSVGshape, lengths in pixels as nanosvg scales them.
+struct StrokeStyle {
+    float width = 0.0f;  // 0 for shapes that are not stroked or not visible
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Butt;
+    float miterLimit = 4.0f;
+    float dashOffset = 0.0f;
+    int dashCount = 0;  // solid when 0
+    float dashes[8] = {};
+    float color[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// Fill of one NSVGshape. Every path of the shape counts as closed.
+struct FillStyle {
+    bool filled = false;  // false for shapes without a fill or not visible
+    FillRule rule = FillRule::NonZero;
+    float color[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// What SvgSegments leaves out of an NSVGimage: per shape paint, per path the closed flag.
+// Indexed by SvgSegments::shapeIds and pathIds.
+struct SvgStyles {
+    std::vector<StrokeStyle> strokes;
+    std::vector<FillStyle> fills;
+    std::vector<uint8_t> closedPaths;
+
+    static SvgStyles fromImage(const NSVGimage* image);
+};
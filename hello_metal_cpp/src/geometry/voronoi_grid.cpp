@@ -0,0 +1,489 @@
+#include "voronoi_grid.h"
+#include "parallel.h"
+#include "simd_float.h"
+#include <algorithm>
+
+// A seed is its closest point on the curve in grid units, packed as 16-bit fixed point
+// x | y << 16 with as many fraction bits as the grid size leaves (3 bits at 8192 cells).
+// One uint32 per cell keeps every pass on a single buffer.
+static const uint32_t kEmpty = UINT32_MAX;
+static const int kMaxFractionBits = 8;
+
+// Flattening tolerance and seed sampling step, in cells
+static const float kSeedTolerance = 0.25f;
+static const float kSeedStep = 0.5f;
+// Segments flattened per work item, and grid rows stamped per work item
+static const size_t kSeedBlock = 64;
+static const int kSeedBandRows = 64;
+// Flood pass tiles: wide enough that each tile row streams several cache lines
+static const int kFloodTileWidth = 256;
+static const int kFloodTileHeight = 32;
+
+static int fractionBitsFor(int maxDimension) {
+    int bits = 0;
+    while (bits < kMaxFractionBits && ((int64_t)maxDimension << (bits + 1)) <= 65536) {
+        bits++;
+    }
+    return bits;
+}
+
+// Quantizes p, which lies in cell (cellX, cellY), without leaving that cell so the seed's
+// cell (and its label) can be recovered with a shift.
+static uint32_t packSeed(const Point2& p, int cellX, int cellY, int bits) {
+    const float scale = (float)(1 << bits);
+    int64_t x = std::clamp((int64_t)(p.x * scale), (int64_t)cellX << bits, (((int64_t)cellX + 1) << bits) - 1);
+    int64_t y = std::clamp((int64_t)(p.y * scale), (int64_t)cellY << bits, (((int64_t)cellY + 1) << bits) - 1);
+    // 0xffff in both halves is kEmpty
+    return (uint32_t)std::min<int64_t>(x, 0xfffe) | ((uint32_t)y << 16);
+}
+
+static size_t seedCell(uint32_t seed, int bits, int width) {
+    return (size_t)((seed >> 16) >> bits) * width + ((seed & 0xffff) >> bits);
+}
+
+// Squared distance in fixed point units from (cx, cy) to the centre of the seed's quantum
+static float seedDistanceSq(uint32_t seed, float cx, float cy) {
+    float dx = (float)(seed & 0xffff) + 0.5f - cx;
+    float dy = (float)(seed >> 16) + 0.5f - cy;
+    return dx * dx + dy * dy;
+}
+
+// A flattened piece of a segment in grid units
+struct SeedPiece {
+    Point2 a, b;
+    uint32_t label;
+};
+
+// Marks every cell in rows [rowBegin, rowEnd) that the piece passes through with its closest
+// point on the piece, keeping the closer seed where pieces share a cell. Only the samples
+// near those rows are visited; they are the same samples whichever rows are asked for.
+// Returns whether any cell was marked.
+static bool stampPiece(const SeedPiece& piece, int rowBegin, int rowEnd, int width, int bits,
+                       std::vector<uint32_t>& seeds, std::vector<uint32_t>& labels, std::vector<float>& bestSq) {
+    const Point2 a = piece.a;
+    const float ex = piece.b.x - a.x, ey = piece.b.y - a.y;
+    const float lengthSq = ex * ex + ey * ey;
+    const int steps = std::max(1, (int)std::ceil(std::sqrt(lengthSq) / kSeedStep));
+    bool stamped = false;
+    int first = 0, last = steps;
+    if (ey != 0.0f) {
+        float s0 = (rowBegin - a.y) / ey, s1 = (rowEnd - a.y) / ey;
+        first = std::max(0, (int)std::floor(std::min(s0, s1) * steps) - 1);
+        last = std::min(steps, (int)std::ceil(std::max(s0, s1) * steps) + 1);
+    }
+    for (int i = first; i <= last; i++) {
+        float s = 1.0f * i / steps;
+        int cellX = (int)std::floor(a.x + ex * s), cellY = (int)std::floor(a.y + ey * s);
+        if (cellX < 0 || cellY < rowBegin || cellX >= width || cellY >= rowEnd) {
+            continue;
+        }
+        Point2 centre = { cellX + 0.5f, cellY + 0.5f };
+        float t = lengthSq > 0.0f ? std::clamp(((centre.x - a.x) * ex + (centre.y - a.y) * ey) / lengthSq, 0.0f, 1.0f) : 0.0f;
+        Point2 q = { std::clamp(a.x + ex * t, (float)cellX, cellX + 1.0f), std::clamp(a.y + ey * t, (float)cellY, cellY + 1.0f) };
+        float d = (q.x - centre.x) * (q.x - centre.x) + (q.y - centre.y) * (q.y - centre.y);
+        size_t cell = (size_t)cellY * width + cellX;
+        if (d < bestSq[cell]) {
+            bestSq[cell] = d;
+            seeds[cell] = packSeed(q, cellX, cellY, bits);
+            labels[cell] = piece.label;
+        }
+        stamped = true;
+    }
+    return stamped;
+}
+
+// Interior columns [begin, end) of one output row, where all 3 columns of every row exist.
+// kLanes cells at a time: each candidate is a contiguous load shifted by the column offset.
+static void floodRowInterior(const uint32_t* const* rows, int rowCount, int step, float cy, float scale,
+                             int begin, int end, uint32_t* out) {
+    const VecU empty = vsetu(kEmpty);
+    const VecF half = vset(0.5f), vscale = vset(scale), vcy = vset(cy);
+    float laneOffsets[kLanes];
+    for (size_t l = 0; l < kLanes; l++) {
+        laneOffsets[l] = (float)l;
+    }
+    const VecF lanes = vload(laneOffsets);
+    int x = begin;
+    for (; x + (int)kLanes <= end; x += (int)kLanes) {
+        const VecF cx = vmul(vadd(vadd(vset((float)x), lanes), half), vscale);
+        VecU best = empty;
+        VecF bestSq = vset(INFINITY);
+        for (int r = 0; r < rowCount; r++) {
+            for (int offset = -step; offset <= step; offset += step) {
+                VecU seed = vloadu(rows[r] + x + offset);
+                VecF dx = vsub(vadd(vlow16(seed), half), cx);
+                VecF dy = vsub(vadd(vhigh16(seed), half), vcy);
+                VecF d = vmadd(dx, dx, vmul(dy, dy));
+                VecMask closer = vandnot(vequalu(seed, empty), vless(d, bestSq));
+                bestSq = vselect(closer, d, bestSq);
+                best = vselectu(closer, seed, best);
+            }
+        }
+        vstoreu(out + x, best);
+    }
+    for (; x < end; x++) {
+        const float cx = (x + 0.5f) * scale;
+        uint32_t best = kEmpty;
+        float bestSq = INFINITY;
+        for (int r = 0; r < rowCount; r++) {
+            for (int offset = -step; offset <= step; offset += step) {
+                uint32_t seed = rows[r][x + offset];
+                float d = seedDistanceSq(seed, cx, cy);
+                if (seed != kEmpty && d < bestSq) {
+                    bestSq = d;
+                    best = seed;
+                }
+            }
+        }
+        out[x] = best;
+    }
+}
+
+// The flood tiles and, per tile, its Chebyshev distance in tiles to the nearest tile holding a
+// seed (0 for those), from a breadth-first search over the tiles.
+struct FloodTiles {
+    int columns = 0;
+    int rows = 0;
+    std::vector<int> seedDistance;
+
+    FloodTiles(const std::vector<uint32_t>& seeds, int width, int height) {
+        columns = (width + kFloodTileWidth - 1) / kFloodTileWidth;
+        rows = (height + kFloodTileHeight - 1) / kFloodTileHeight;
+        seedDistance.assign((size_t)columns * rows, INT32_MAX);
+        std::vector<uint8_t> seeded(seedDistance.size(), 0);
+        Parallel::forEach(seedDistance.size(), [&](size_t tile) {
+            int x0 = (int)(tile % columns) * kFloodTileWidth, x1 = std::min(width, x0 + kFloodTileWidth);
+            int y0 = (int)(tile / columns) * kFloodTileHeight, y1 = std::min(height, y0 + kFloodTileHeight);
+            for (int y = y0; y < y1 && !seeded[tile]; y++) {
+                const uint32_t* row = seeds.data() + (size_t)y * width;
+                seeded[tile] = std::any_of(row + x0, row + x1, [](uint32_t seed) { return seed != kEmpty; });
+            }
+        });
+        std::vector<size_t> queue;
+        for (size_t tile = 0; tile < seeded.size(); tile++) {
+            if (seeded[tile]) {
+                seedDistance[tile] = 0;
+                queue.push_back(tile);
+            }
+        }
+        for (size_t next = 0; next < queue.size(); next++) {
+            int tx = (int)(queue[next] % columns), ty = (int)(queue[next] / columns);
+            for (int ny = std::max(ty - 1, 0); ny <= std::min(ty + 1, rows - 1); ny++) {
+                for (int nx = std::max(tx - 1, 0); nx <= std::min(tx + 1, columns - 1); nx++) {
+                    size_t neighbour = (size_t)ny * columns + nx;
+                    if (seedDistance[neighbour] == INT32_MAX) {
+                        seedDistance[neighbour] = seedDistance[queue[next]] + 1;
+                        queue.push_back(neighbour);
+                    }
+                }
+            }
+        }
+    }
+};
+
+// One jump flooding pass: every cell looks at its 8 neighbours `step` cells away and keeps
+// the closest seed seen. Tiles run in parallel, each reading src and writing dst; only the
+// columns within `step` of the left and right edges need bounds checks. A tile is copied
+// through when the pass has nothing for it: its cells stay empty while no seed lies within
+// `reach` (the steps so far, this one included), and a step over twice the farthest any of
+// its cells can be from a seed only looks beyond that seed, the cut-off plain JFA makes with
+// its largest step.
+static void floodPass(const uint32_t* src, uint32_t* dst, int width, int height, int step, int reach, int bits,
+                      const FloodTiles& tiles) {
+    const float scale = (float)(1 << bits);
+    Parallel::forEach((size_t)tiles.columns * tiles.rows, [&](size_t tile) {
+        int x0 = (int)(tile % tiles.columns) * kFloodTileWidth, x1 = std::min(width, x0 + kFloodTileWidth);
+        int y0 = (int)(tile / tiles.columns) * kFloodTileHeight, y1 = std::min(height, y0 + kFloodTileHeight);
+        // Tiles `distance` apart are at least (distance - 1) short sides apart in cells, and a
+        // tile's cells are within (distance + 1) diagonals, under width + height, of a seed.
+        const int64_t distance = tiles.seedDistance[tile];
+        const bool empty = distance > 0 && (distance - 1) * std::min(kFloodTileWidth, kFloodTileHeight) >= reach;
+        const bool beyond = step > 2 * (distance + 1) * (kFloodTileWidth + kFloodTileHeight);
+        if (empty || beyond) {
+            for (int y = y0; y < y1; y++) {
+                std::copy(src + (size_t)y * width + x0, src + (size_t)y * width + x1, dst + (size_t)y * width + x0);
+            }
+            return;
+        }
+        for (int y = y0; y < y1; y++) {
+            const uint32_t* rows[3];
+            int rowCount = 0;
+            for (int ny : { y - step, y, y + step }) {
+                if (ny >= 0 && ny < height) {
+                    rows[rowCount++] = src + (size_t)ny * width;
+                }
+            }
+            const float cy = (y + 0.5f) * scale;
+            uint32_t* out = dst + (size_t)y * width;
+            auto floodEdge = [&](int x) {
+                const float cx = (x + 0.5f) * scale;
+                const int firstColumn = x - step >= 0 ? x - step : x, lastColumn = x + step < width ? x + step : x;
+                uint32_t best = kEmpty;
+                float bestSq = INFINITY;
+                for (int r = 0; r < rowCount; r++) {
+                    for (int column = firstColumn; column <= lastColumn; column += step) {
+                        uint32_t seed = rows[r][column];
+                        float d = seed != kEmpty ? seedDistanceSq(seed, cx, cy) : INFINITY;
+                        if (d < bestSq) {
+                            bestSq = d;
+                            best = seed;
+                        }
+                    }
+                }
+                out[x] = best;
+            };
+            const int interiorBegin = std::clamp(step, x0, x1), interiorEnd = std::clamp(width - step, interiorBegin, x1);
+            for (int x = x0; x < interiorBegin; x++) {
+                floodEdge(x);
+            }
+            floodRowInterior(rows, rowCount, step, cy, scale, interiorBegin, interiorEnd, out);
+            for (int x = interiorEnd; x < x1; x++) {
+                floodEdge(x);
+            }
+        }
+    });
+}
+
+// Lays the grid over the domain and stamps the seeds shared by both transforms. Returns
+// false, with every cell unlabeled, when there is nothing to seed: no cells, no segments,
+// or no segment inside the domain.
+static bool seedGrid(const CubicSegmentsSoA& segments, const VoronoiGridOptions& options, VoronoiGrid& grid,
+                     std::vector<uint32_t>& seeds, std::vector<uint32_t>& labels, int& bits) {
+    grid.width = std::clamp(options.width, 0, 65535);
+    grid.height = std::clamp(options.height, 0, 65535);
+    const int width = grid.width, height = grid.height;
+    const size_t cells = (size_t)width * height;
+    grid.distance.assign(cells, INFINITY);
+    if (cells == 0 || segments.size() == 0) {
+        grid.segment.assign(cells, VoronoiGrid::kInvalid);
+        return false;
+    }
+
+    Box2 domain = options.domain;
+    if (domain.min.x > domain.max.x || domain.min.y > domain.max.y) {
+        domain = Box2();
+        for (size_t i = 0; i < segments.size(); i++) {
+            domain.expand(Bezier::bounds(segments.get(i)));
+        }
+    }
+    float w = domain.max.x - domain.min.x, h = domain.max.y - domain.min.y;
+    grid.cellSize = std::max(w / width, h / height);
+    if (!(grid.cellSize > 0.0f)) {
+        grid.cellSize = 1.0f;
+    }
+    Point2 centre = domain.center();
+    grid.origin = { centre.x - 0.5f * width * grid.cellSize, centre.y - 0.5f * height * grid.cellSize };
+
+    // Seeding costs grow with the curve length in cells, not with the grid area. Blocks of
+    // segments are flattened in parallel, the pieces are bucketed by the bands of rows they
+    // touch, in segment order, and the bands are stamped in parallel; within a band pieces
+    // come in the same order as a serial pass, so ties resolve the same way.
+    // grid.distance holds the squared seed distances until the transform overwrites it.
+    bits = fractionBitsFor(std::max(width, height));
+    seeds.assign(cells, kEmpty);
+    labels.assign(cells, VoronoiGrid::kInvalid);
+    const float toGrid = 1.0f / grid.cellSize;
+    const size_t blocks = (segments.size() + kSeedBlock - 1) / kSeedBlock;
+    std::vector<std::vector<SeedPiece>> blockPieces(blocks);
+    Parallel::forEach(blocks, [&](size_t block) {
+        std::vector<Point2> polyline;
+        size_t end = std::min(segments.size(), (block + 1) * kSeedBlock);
+        for (size_t i = block * kSeedBlock; i < end; i++) {
+            CubicSegment c = segments.get(i);
+            for (Point2* p : { &c.p0, &c.p1, &c.p2, &c.p3 }) {
+                *p = { (p->x - grid.origin.x) * toGrid, (p->y - grid.origin.y) * toGrid };
+            }
+            polyline.clear();
+            Bezier::flattenAdaptive(c, kSeedTolerance, polyline);
+            for (size_t j = 1; j < polyline.size(); j++) {
+                blockPieces[block].push_back({ polyline[j - 1], polyline[j], (uint32_t)i });
+            }
+        }
+    });
+
+    const int bands = (height + kSeedBandRows - 1) / kSeedBandRows;
+    auto bandRange = [&](const SeedPiece& piece, int& firstBand, int& lastBand) {
+        float low = std::floor(std::min(piece.a.y, piece.b.y) / kSeedBandRows);
+        float high = std::floor(std::max(piece.a.y, piece.b.y) / kSeedBandRows);
+        firstBand = (int)std::clamp(low, 0.0f, (float)bands);
+        lastBand = (int)std::clamp(high, -1.0f, (float)bands - 1);
+    };
+    std::vector<size_t> bandStart(bands + 1, 0);
+    for (const std::vector<SeedPiece>& pieces : blockPieces) {
+        for (const SeedPiece& piece : pieces) {
+            int firstBand, lastBand;
+            bandRange(piece, firstBand, lastBand);
+            for (int band = firstBand; band <= lastBand; band++) {
+                bandStart[band + 1]++;
+            }
+        }
+    }
+    for (int band = 0; band < bands; band++) {
+        bandStart[band + 1] += bandStart[band];
+    }
+    std::vector<const SeedPiece*> bandPieces(bandStart[bands]);
+    std::vector<size_t> fill(bandStart.begin(), bandStart.end() - 1);
+    for (const std::vector<SeedPiece>& pieces : blockPieces) {
+        for (const SeedPiece& piece : pieces) {
+            int firstBand, lastBand;
+            bandRange(piece, firstBand, lastBand);
+            for (int band = firstBand; band <= lastBand; band++) {
+                bandPieces[fill[band]++] = &piece;
+            }
+        }
+    }
+    std::vector<uint8_t> bandStamped(bands, 0);
+    Parallel::forEach((size_t)bands, [&](size_t band) {
+        int rowBegin = (int)band * kSeedBandRows, rowEnd = std::min(height, rowBegin + kSeedBandRows);
+        for (size_t i = bandStart[band]; i < bandStart[band + 1]; i++) {
+            if (stampPiece(*bandPieces[i], rowBegin, rowEnd, width, bits, seeds, labels, grid.distance)) {
+                bandStamped[band] = 1;
+            }
+        }
+    });
+    if (std::find(bandStamped.begin(), bandStamped.end(), 1) == bandStamped.end()) {
+        grid.segment.assign(cells, VoronoiGrid::kInvalid);
+        return false;
+    }
+    return true;
+}
+
+VoronoiGrid Voronoi::jumpFlood(const CubicSegmentsSoA& segments, const VoronoiGridOptions& options) {
+    VoronoiGrid grid;
+    std::vector<uint32_t> seeds, labels;
+    int bits = 0;
+    if (!seedGrid(segments, options, grid, seeds, labels, bits)) {
+        return grid;
+    }
+    const int width = grid.width, height = grid.height;
+    const size_t cells = (size_t)width * height;
+
+    // 1+JFA: a step 1 pass ahead of the usual halving sequence removes most of the errors
+    // plain jump flooding leaves near thin Voronoi regions.
+    std::vector<uint32_t> flooded(cells);
+    std::vector<int> stepSizes = { 1 };
+    int maxStep = 1;
+    while (maxStep * 2 < std::max(width, height)) {
+        maxStep *= 2;
+    }
+    for (int step = maxStep; step >= 1; step /= 2) {
+        stepSizes.push_back(step);
+    }
+    const FloodTiles tiles(seeds, width, height);
+    int reach = 0;
+    for (int step : stepSizes) {
+        reach = (int)std::min<int64_t>((int64_t)reach + step, INT32_MAX);
+        floodPass(seeds.data(), flooded.data(), width, height, step, reach, bits, tiles);
+        seeds.swap(flooded);
+    }
+
+    // Resolve labels and distances; `flooded` is free again and becomes the label array
+    const float toDomain = grid.cellSize / (float)(1 << bits);
+    Parallel::forRange((size_t)height, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            const float cy = (y + 0.5f) * (float)(1 << bits);
+            for (int x = 0; x < width; x++) {
+                size_t cell = y * width + x;
+                uint32_t seed = seeds[cell];
+                if (seed == kEmpty) {
+                    flooded[cell] = VoronoiGrid::kInvalid;
+                    grid.distance[cell] = INFINITY;
+                    continue;
+                }
+                flooded[cell] = labels[seedCell(seed, bits, width)];
+                grid.distance[cell] = std::sqrt(seedDistanceSq(seed, (x + 0.5f) * (float)(1 << bits), cy)) * toDomain;
+            }
+        }
+    }, 16);
+    grid.segment = std::move(flooded);
+    return grid;
+}
+
+VoronoiGrid Voronoi::distanceTransform(const CubicSegmentsSoA& segments, const VoronoiGridOptions& options) {
+    VoronoiGrid grid;
+    std::vector<uint32_t> seeds, labels;
+    int bits = 0;
+    if (!seedGrid(segments, options, grid, seeds, labels, bits)) {
+        return grid;
+    }
+    const int width = grid.width, height = grid.height;
+
+    // Column pass: row of the nearest seed in the same column, from a downward and an upward
+    // scan. Bands of columns run in parallel and every scan step reads a contiguous run.
+    std::vector<uint32_t> nearestRow((size_t)width * height);
+    Parallel::forRange((size_t)width, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> last(end - begin, kEmpty);
+        for (int y = 0; y < height; y++) {
+            const uint32_t* seedRow = seeds.data() + (size_t)y * width;
+            uint32_t* out = nearestRow.data() + (size_t)y * width;
+            for (size_t x = begin; x < end; x++) {
+                last[x - begin] = seedRow[x] != kEmpty ? (uint32_t)y : last[x - begin];
+                out[x] = last[x - begin];
+            }
+        }
+        std::fill(last.begin(), last.end(), kEmpty);
+        for (int y = height - 1; y >= 0; y--) {
+            const uint32_t* seedRow = seeds.data() + (size_t)y * width;
+            uint32_t* out = nearestRow.data() + (size_t)y * width;
+            for (size_t x = begin; x < end; x++) {
+                last[x - begin] = seedRow[x] != kEmpty ? (uint32_t)y : last[x - begin];
+                uint32_t below = last[x - begin];
+                if (below != kEmpty && (out[x] == kEmpty || below - y < y - out[x])) {
+                    out[x] = below;
+                }
+            }
+        }
+    }, 64);
+
+    // Row pass: lower envelope of the parabolas (x - q)^2 + (y - nearestRow[q])^2 over the
+    // columns q that have a seed (Felzenszwalb-Huttenlocher), then one sweep to read it off.
+    // Each row is written back over its own nearestRow entries, which end up as the labels.
+    const float scale = (float)(1 << bits);
+    const float toDomain = grid.cellSize / scale;
+    Parallel::forRange((size_t)height, [&](size_t begin, size_t end) {
+        std::vector<int> envelope(width);
+        std::vector<double> boundary(width + 1), f(width);
+        std::vector<uint32_t> rowOf(width);
+        for (int y = (int)begin; y < (int)end; y++) {
+            uint32_t* row = nearestRow.data() + (size_t)y * width;
+            std::copy(row, row + width, rowOf.begin());
+            int k = -1;
+            for (int q = 0; q < width; q++) {
+                if (rowOf[q] == kEmpty) {
+                    continue;
+                }
+                double dy = (double)y - rowOf[q];
+                f[q] = dy * dy;
+                double s = -INFINITY;
+                while (k >= 0) {
+                    int v = envelope[k];
+                    s = ((f[q] + (double)q * q) - (f[v] + (double)v * v)) / (2.0 * (q - v));
+                    if (s > boundary[k]) {
+                        break;
+                    }
+                    k--;
+                }
+                k++;
+                envelope[k] = q;
+                boundary[k] = k == 0 ? -INFINITY : s;
+                boundary[k + 1] = INFINITY;
+            }
+
+            const float cy = (y + 0.5f) * scale;
+            float* distance = grid.distance.data() + (size_t)y * width;
+            k = 0;
+            for (int x = 0; x < width; x++) {
+                while (boundary[k + 1] < x) {
+                    k++;
+                }
+                int q = envelope[k];
+                size_t cell = (size_t)rowOf[q] * width + q;
+                uint32_t seed = seeds[cell];
+                row[x] = labels[cell];
+                distance[x] = std::sqrt(seedDistanceSq(seed, (x + 0.5f) * scale, cy)) * toDomain;
+            }
+        }
+    }, 16);
+    grid.segment = std::move(nearestRow);
+    return grid;
+}
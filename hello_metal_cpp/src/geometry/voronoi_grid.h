@@ -0,0 +1,47 @@
+#pragma once
+#include "bezier.h"
+#include "bezier_batch.h"
+#include <cstdint>
+#include <vector>
+
+// Nearest-segment id and distance for every cell of a width x height grid laid over `domain`.
+// Cells are square; cell (x, y) has its centre at origin + (x + 0.5, y + 0.5) * cellSize.
+struct VoronoiGrid {
+    static constexpr uint32_t kInvalid = UINT32_MAX;
+
+    int width = 0;
+    int height = 0;
+    Point2 origin = { 0.0f, 0.0f };
+    float cellSize = 1.0f;
+    std::vector<uint32_t> segment;  // row-major, kInvalid when there are no segments
+    std::vector<float> distance;    // in domain units
+
+    size_t size() const { return segment.size(); }
+    Point2 cellCenter(int x, int y) const {
+        return { origin.x + (x + 0.5f) * cellSize, origin.y + (y + 0.5f) * cellSize };
+    }
+};
+
+struct VoronoiGridOptions {
+    int width = 1024;
+    int height = 1024;
+    // Area covered by the grid; an empty box means the bounds of all segments. The shorter
+    // side is grown so cells stay square.
+    Box2 domain;
+};
+
+namespace Voronoi {
+    // Jump flooding with the 1+JFA correction pass: the segments are flattened to within a
+    // quarter cell, every cell they cross becomes a seed holding its closest point on the
+    // polyline, and passes with step 1, N/2, N/4, ..., 1 propagate seeds over the grid.
+    // Seeding runs in row bands and each pass in 256x32 tiles across all cores; a pass copies
+    // through tiles it cannot change. Grids up to 65535 cells per side; memory peaks at 16
+    // bytes per cell plus the flattened pieces.
+    VoronoiGrid jumpFlood(const CubicSegmentsSoA& segments, const VoronoiGridOptions& options = VoronoiGridOptions());
+
+    // Exact separable Euclidean distance transform over the same seeds: a column pass finds the
+    // nearest seed row per column, a row pass takes the lower envelope of parabolas
+    // (Felzenszwalb-Huttenlocher). The nearest seed cell is exact; the reported distance is
+    // to that seed's point on the curve. Both passes run in parallel. 16 bytes per cell.
+    VoronoiGrid distanceTransform(const CubicSegmentsSoA& segments, const VoronoiGridOptions& options = VoronoiGridOptions());
+}
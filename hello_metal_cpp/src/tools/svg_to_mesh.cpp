@@ -0,0 +1,298 @@
+// Headless batch converter, not part of the app target. Build from hello_metal_cpp/src:
+//   c++ -std=c++20 -O2 -I external tools/svg_to_mesh.cpp geometry/*.cpp -o svg_to_mesh -pthread
+// Usage: svg_to_mesh [options] <file.svg | directory>...
+// Runs buildSVG's CPU pipeline (parse, flatten, normals, indices) for every SVG and writes the
+// curve cache with the mesh in it, so the app maps the result instead of tessellating. With
+// --stroke the stroked outlines (StrokeMesh) and with --fill the filled interiors (FillMesh)
+// are baked into the same cache.
+// Directories are searched recursively for *.svg; files run concurrently on a work-stealing pool.
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#include "../geometry/curve_cache.h"
+#include "../geometry/fill.h"
+#include "../geometry/parallel.h"
+#include "../geometry/stroke.h"
+#include "../geometry/svg_mesh.h"
+#include "../geometry/svg_segments.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Job {
+    fs::path source;
+    fs::path output;
+};
+
+struct JobResult {
+    bool ok = false;
+    const char* error = nullptr;
+    size_t bytes = 0;
+    size_t segments = 0;
+    SegmentStats stats;  // segments by class, as SvgMesh::build sorted them
+    size_t vertices = 0;
+    size_t indices = 0;
+    size_t strokeVertices = 0;
+    size_t fillVertices = 0;
+    double parseMs = 0.0;
+    double meshMs = 0.0;
+    double writeMs = 0.0;
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: svg_to_mesh [options] <file.svg | directory>...\n"
+            "  -o <dir>            write caches under <dir> (default: next to each SVG, where buildSVG looks)\n"
+            "  -j <threads>        worker threads (default: all cores)\n"
+            "  --mode <name>       adaptive, uniform or arclength (default: adaptive)\n"
+            "  --tolerance <px>    flattening tolerance in screen pixels (default: 0.25)\n"
+            "  --spacing <px>      vertex spacing in arclength mode (default: 4)\n"
+            "  --viewport <px>     pixels covered by the NDC range (default: 600)\n"
+            "  --normal-length <d> reach of the normal bands to either side, in NDC (default: 0.1)\n"
+            "  --normal-points <n> points per segment along the normal bands (default: 2, the end points)\n"
+            "  --stroke            also bake stroke meshes (joins, caps, dashes) from the shapes' stroke styles\n"
+            "  --fill              also bake fill meshes (nonzero and even-odd) from the shapes' fill styles\n"
+            "  -q                  aggregate only, no line per file\n");
+}
+
+static bool isSvg(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return extension == ".svg";
+}
+
+// Cache path for `source`; under an output directory the part below the searched directory is kept
+static fs::path outputPath(const fs::path& source, const fs::path& relative, const fs::path& outputDir) {
+    if (outputDir.empty()) {
+        return CurveCache::defaultPath(source.string().c_str());
+    }
+    return outputDir / CurveCache::defaultPath(relative.string().c_str());
+}
+
+static bool collectJobs(const char* argument, const fs::path& outputDir, std::vector<Job>& jobs) {
+    fs::path input(argument);
+    std::error_code error;
+    if (fs::is_directory(input, error)) {
+        for (fs::recursive_directory_iterator it(input, fs::directory_options::skip_permission_denied, error), end;
+             it != end; it.increment(error)) {
+            if (it->is_regular_file(error) && isSvg(it->path())) {
+                jobs.push_back({ it->path(), outputPath(it->path(), it->path().lexically_relative(input), outputDir) });
+            }
+        }
+        return !error;
+    }
+    if (fs::is_regular_file(input, error)) {
+        jobs.push_back({ input, outputPath(input, input.filename(), outputDir) });
+        return true;
+    }
+    return false;
+}
+
+static JobResult convert(const Job& job, const TessellationOptions& options, bool stroke, bool fill) {
+    JobResult result;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sourceHash = 0;
+    if (!CurveCache::hashFile(job.source.c_str(), sourceHash)) {
+        result.error = "cannot read";
+        return result;
+    }
+    std::error_code error;
+    result.bytes = (size_t)fs::file_size(job.source, error);
+    SvgSegments svg;
+    SvgStyles styles;
+    if (stroke || fill) {
+        // Stroke and fill styles only exist in the full parse
+        NSVGimage* image = nsvgParseFromFile(job.source.c_str(), "px", 96.0f);
+        svg = SvgSegments::fromImage(image);
+        styles = SvgStyles::fromImage(image);
+        if (image) {
+            nsvgDelete(image);
+        }
+    } else {
+        svg = SvgSegments::fromFile(job.source.c_str());
+    }
+    result.parseMs = elapsedMs(start);
+    result.segments = svg.size();
+    if (svg.size() == 0) {
+        result.error = "no geometry";
+        return result;
+    }
+
+    start = std::chrono::steady_clock::now();
+    SvgMesh mesh = SvgMesh::build(svg, options);
+    result.meshMs = elapsedMs(start);
+    result.stats = mesh.stats;
+    result.vertices = mesh.vertices.size();
+    result.indices = mesh.indexCount();
+    StrokeMesh strokeMesh;
+    if (stroke) {
+        strokeMesh = StrokeMesh::build(svg, styles, options);
+        result.meshMs = elapsedMs(start);
+        result.strokeVertices = strokeMesh.vertices.size();
+    }
+    FillMesh fillMesh;
+    if (fill) {
+        fillMesh = FillMesh::build(svg, styles, options);
+        result.meshMs = elapsedMs(start);
+        result.fillVertices = fillMesh.vertices.size();
+    }
+    std::vector<CurveCache::Blob> extraBlobs;
+    if (stroke) {
+        extraBlobs = strokeMesh.cacheBlobs();
+    }
+    if (fill) {
+        std::vector<CurveCache::Blob> fillBlobs = fillMesh.cacheBlobs();
+        extraBlobs.insert(extraBlobs.end(), fillBlobs.begin(), fillBlobs.end());
+    }
+
+    start = std::chrono::steady_clock::now();
+    if (job.output.has_parent_path()) {
+        fs::create_directories(job.output.parent_path(), error);
+    }
+    if (!mesh.writeCache(job.output.c_str(), sourceHash, svg, extraBlobs)) {
+        result.error = "cannot write cache";
+        return result;
+    }
+    result.writeMs = elapsedMs(start);
+    result.ok = true;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    TessellationOptions options;
+    fs::path outputDir;
+    unsigned threads = Parallel::threadCount();
+    bool quiet = false;
+    bool stroke = false;
+    bool fill = false;
+    std::vector<const char*> inputs;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(arg, "--stroke") == 0) {
+            stroke = true;
+        } else if (strcmp(arg, "--fill") == 0) {
+            fill = true;
+        } else if (arg[0] == '-' && !value) {
+            usage();
+            return 2;
+        } else if (strcmp(arg, "-o") == 0) {
+            outputDir = argv[++i];
+        } else if (strcmp(arg, "-j") == 0) {
+            threads = (unsigned)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            options.tolerancePixels = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--spacing") == 0) {
+            options.arcSpacingPixels = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--viewport") == 0) {
+            options.viewportPixels = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--normal-length") == 0) {
+            options.normalLength = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--normal-points") == 0) {
+            options.normalSamples = atoi(argv[++i]);
+        } else if (strcmp(arg, "--mode") == 0) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "adaptive") == 0) {
+                options.mode = TessellationMode::Adaptive;
+            } else if (strcmp(mode, "uniform") == 0) {
+                options.mode = TessellationMode::Uniform;
+            } else if (strcmp(mode, "arclength") == 0) {
+                options.mode = TessellationMode::ArcLength;
+            } else {
+                usage();
+                return 2;
+            }
+        } else if (arg[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || options.tolerancePixels <= 0.0f || options.arcSpacingPixels <= 0.0f || options.viewportPixels <= 0.0f
+        || options.normalSamples < 2) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Job> jobs;
+    for (const char* input : inputs) {
+        if (!collectJobs(input, outputDir, jobs)) {
+            fprintf(stderr, "svg_to_mesh: cannot read %s\n", input);
+            return 1;
+        }
+    }
+    // Largest files first, so the last files to finish are small ones
+    std::vector<size_t> sizes(jobs.size());
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        std::error_code error;
+        sizes[i] = (size_t)fs::file_size(jobs[i].source, error);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<JobResult> results(jobs.size());
+    std::mutex printLock;
+    std::atomic<size_t> finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    Parallel::forEach(jobs.size(), [&](size_t k) {
+        size_t i = order[k];
+        results[i] = convert(jobs[i], options, stroke, fill);
+        size_t done = ++finished;
+        if (quiet && results[i].ok) {
+            return;
+        }
+        const JobResult& r = results[i];
+        double ms = r.parseMs + r.meshMs + r.writeMs;
+        std::lock_guard<std::mutex> guard(printLock);
+        if (r.ok) {
+            printf("[%zu/%zu] %s  %.2f MB  %zu segments (%zu lines, %zu quadratic, %zu cubic)  %zu vertices  %zu %d-bit indices  %zu stroke vertices  %zu fill vertices  parse %.2f  mesh %.2f  write %.2f ms  %.1f MB/s\n",
+                   done, jobs.size(), jobs[i].source.c_str(), r.bytes / 1e6, r.segments, r.stats.lines, r.stats.quadratics, r.stats.cubics, r.vertices, r.indices,
+                   8 * (int)SvgMesh::indexTypeFor(r.vertices), r.strokeVertices, r.fillVertices, r.parseMs, r.meshMs, r.writeMs,
+                   r.bytes / 1e6 / (ms / 1000.0));
+        } else {
+            fprintf(stderr, "[%zu/%zu] %s: %s\n", done, jobs.size(), jobs[i].source.c_str(), r.error);
+        }
+    }, threads);
+    double wallMs = elapsedMs(start);
+
+    JobResult total;
+    size_t converted = 0;
+    for (const JobResult& r : results) {
+        converted += r.ok;
+        total.bytes += r.bytes;
+        total.segments += r.segments;
+        total.stats.lines += r.stats.lines;
+        total.stats.quadratics += r.stats.quadratics;
+        total.stats.cubics += r.stats.cubics;
+        total.vertices += r.vertices;
+        total.indices += r.indices;
+        total.parseMs += r.parseMs;
+        total.meshMs += r.meshMs;
+        total.writeMs += r.writeMs;
+    }
+    double seconds = wallMs / 1000.0;
+    printf("%zu of %zu files converted on %u threads in %.2f s: %.1f files/s, %.1f MB/s, %.2f M segments/s, %.2f M vertices/s\n",
+           converted, jobs.size(), std::min<unsigned>(threads, (unsigned)std::max<size_t>(jobs.size(), 1)), seconds,
+           jobs.size() / seconds, total.bytes / 1e6 / seconds, total.segments / 1e6 / seconds, total.vertices / 1e6 / seconds);
+    printf("segments: %zu lines, %zu quadratic, %zu cubic\n", total.stats.lines, total.stats.quadratics, total.stats.cubics);
+    printf("thread time: parse %.2f s, mesh %.2f s, write %.2f s\n", total.parseMs / 1000.0, total.meshMs / 1000.0,
+           total.writeMs / 1000.0);
+    return converted == jobs.size() ? 0 : 1;
+}
@@ -4,107 +4,40 @@
 #include <fstream>
 #include "nanosvg.h"
 #include "config.h"
+#include "../geometry/forward_difference.h"
+#include "../geometry/svg_segments.h"
+#include "../geometry/curve_cache.h"
+#include "../geometry/packed_vertex.h"
+#include "../geometry/fill.h"
+#include "../geometry/stroke.h"
 #include <cmath>
+#include <cstddef>
 
 using namespace std;
 
-//logic: calculate tangent vectors-> normalize them -> calculate normal by 90deg rotation
-std::pair<float, float> normalize(float x, float y) {
-    float length = std::sqrt(x * x + y * y);
-    return { x / length, y / length };
+static CubicSegment ToCubicSegment(const Vertex& p0, const Vertex& p1, const Vertex& p2, const Vertex& p3) {
+    return { { p0.pos[0], p0.pos[1] }, { p1.pos[0], p1.pos[1] }, { p2.pos[0], p2.pos[1] }, { p3.pos[0], p3.pos[1] } };
 }
 
-std::pair<float, float> CubicBezierTangent(const std::pair<float, float>& p0, const std::pair<float, float>& p1, const std::pair<float, float>& p2, const std::pair<float, float>& p3, float t) {
-    float x = 3 * (1 - t) * (1 - t) * (p1.first - p0.first) + 6 * (1 - t) * t * (p2.first - p1.first) + 3 * t * t * (p3.first - p2.first);
-    float y = 3 * (1 - t) * (1 - t) * (p1.second - p0.second) + 6 * (1 - t) * t * (p2.second - p1.second) + 3 * t * t * (p3.second - p2.second);
-    return { x, y };
-}
-
-void GenerateUnitNormalVertices(const Vertex& startPoint, const Vertex& controlPoint1, const Vertex& controlPoint2, const Vertex& endPoint, int numLines, std::vector<Vertex> &vertices, std::vector<ushort> &indices, ushort &index) {
-    // Calculate tangent vector at start point
-    auto[startTangentX, startTangentY] = CubicBezierTangent({ startPoint.pos[0], startPoint.pos[1] }, { controlPoint1.pos[0], controlPoint1.pos[1] }, { controlPoint2.pos[0], controlPoint2.pos[1] }, { endPoint.pos[0], endPoint.pos[1] }, 0.0f);
-    // Calculate tangent vector at end point
-    auto[endTangentX, endTangentY] = CubicBezierTangent({ startPoint.pos[0], startPoint.pos[1] }, { controlPoint1.pos[0], controlPoint1.pos[1] }, { controlPoint2.pos[0], controlPoint2.pos[1] }, { endPoint.pos[0], endPoint.pos[1] }, 1.0f);
-
-    // Normalize tangent vectors
-    auto[startTangentXNorm, startTangentYNorm] = normalize(startTangentX, startTangentY);
-    auto[endTangentXNorm, endTangentYNorm] = normalize(endTangentX, endTangentY);
-
-    // Calculate normal vectors by rotating tangent vectors by 90 degrees
-    float startNormalX = -startTangentYNorm;
-    float startNormalY = startTangentXNorm;
-    float endNormalX = -endTangentYNorm;
-    float endNormalY = endTangentXNorm;
-
-    // Define length for visualizing normals
-    float normalLength = 0.1f;
-
-    // Calculate end points of the normals (both positive and negative)
-    Vertex startNormalEndPointPos = { { startPoint.pos[0] + startNormalX * normalLength, startPoint.pos[1] + startNormalY * normalLength }, { 1.0f, 0.0f, 0.0f } };
-    Vertex startNormalEndPointNeg = { { startPoint.pos[0] - startNormalX * normalLength, startPoint.pos[1] - startNormalY * normalLength }, { 1.0f, 0.0f, 0.0f } };
-    Vertex endNormalEndPointPos = { { endPoint.pos[0] + endNormalX * normalLength, endPoint.pos[1] + endNormalY * normalLength }, { 1.0f, 0.0f, 0.0f } };
-    Vertex endNormalEndPointNeg = { { endPoint.pos[0] - endNormalX * normalLength, endPoint.pos[1] - endNormalY * normalLength }, { 1.0f, 0.0f, 0.0f } };
-
-    //for rect:
-    // Add vertices for normals (both positive and negative)
-    vertices.push_back(endNormalEndPointPos);  // 0: End of positive normal at start point
-    vertices.push_back(startNormalEndPointPos);    // 1: End of positive normal at end point
-    vertices.push_back(startNormalEndPointNeg);    // 2: End of negative normal at end point
-    vertices.push_back(endNormalEndPointNeg);  // 3: End of negative normal at start point
-    vertices.push_back(endNormalEndPointPos);
-    // Add indices to form the rectangle (two triangles)
-    indices.push_back(index);     // 0
-    indices.push_back(index + 1); // 1
-    indices.push_back(index + 2); // 2
-
-    indices.push_back(index );     // 0
-    indices.push_back(index + 2); // 2
-    indices.push_back(index + 3); // 3
-
-    index += 4; // Move to the next set of vertices
-}
-
-
+// Fixed 0.002 step in t (500 lines), stepped with forward differences.
 void GenerateCubicBezierVertices(const Vertex& startPoint, const Vertex& controlPoint1, const Vertex& controlPoint2, const Vertex& endPoint, int numLines, std::vector<Vertex> &vertices, std::vector<ushort> &indices, ushort &index){
-    for(float i = 0; i<=1; i+=0.002){
-        float t = 1.0f*i;
-        float t2 = t*t;
-        float t3 = t2*t;
-        float t_dash = (1.0f - t);
-        float t_dash2 = t_dash*t_dash;
-        float t_dash3 = t_dash*t_dash2;
-
+    std::vector<Point2> points;
+    Bezier::sampleUniform(ToCubicSegment(startPoint, controlPoint1, controlPoint2, endPoint), 500, points);
+    for (const Point2& point : points) {
         Vertex cur;
-        cur.pos[0] = (t_dash3) * startPoint.pos[0] + (3*t_dash2*t)*controlPoint1
-            .pos[0] + (3*t_dash*t2)*controlPoint2.pos[0] + t3*endPoint.pos[0];
-        cur.pos[1] = (t_dash3) * startPoint.pos[1] + (3*t_dash2*t)*controlPoint1.pos[1] + (3*t_dash*t2)*controlPoint2.pos[1] + t3*endPoint.pos[1];
-
-
-        std::clamp(cur.pos[0], -1.0f, 1.0f);
-        std::clamp(cur.pos[1], -1.0f, 1.0f);
+        cur.pos[0] = point.x;
+        cur.pos[1] = point.y;
         cur.color= {0.0f,0.0f,0.0f};
         vertices.push_back(cur);
-//        indices.push_back(index);
-//        index++;
     }
 }
 std::vector<Vertex> GenerateCubicBezierVerticesFromPoints( const Vertex& p0, const Vertex& p1, const Vertex& p2, const Vertex& p3, int numLines){
-    std::vector<Vertex> vertices;
-    for(int i = 0; i<=numLines; i++){
-        // generate the vertex for the current value of t
-        float t = 1.0f*i/numLines;
-        float t2 = t*t;
-        float t3 = t2*t;
-        float t_dash = (1.0f - t);
-        float t_dash2 = t_dash*t_dash;
-        float t_dash3 = t_dash*t_dash;
-        Vertex cur;
-        cur.pos[0] = (t_dash3) * p0.pos[0] + (3*t_dash2*t)*p1.pos[0] + (3*t_dash*t2)*p2.pos[0] + t3*p3.pos[0];
-        cur.pos[1] = (t_dash3) * p0.pos[1] + (3*t_dash2*t)*p1.pos[1] + (3*t_dash*t2)*p2.pos[1] + t3*p3.pos[1];
-        std::clamp(cur.pos[0], -1.0f, 1.0f);
-        std::clamp(cur.pos[1], -1.0f, 1.0f);
-        vertices.push_back(cur);
-//        return cur;
+    std::vector<Point2> points;
+    Bezier::sampleUniform(ToCubicSegment(p0, p1, p2, p3), numLines, points);
+    std::vector<Vertex> vertices(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        vertices[i].pos[0] = points[i].x;
+        vertices[i].pos[1] = points[i].y;
     }
     return vertices;
 }
@@ -151,77 +84,178 @@ Mesh MeshFactory::buildQuad(MTL::Device* device) {
     // Index buffer
     mesh.indexBuffer = device->newBuffer(8 * sizeof(ushort), MTL::ResourceStorageModeShared);
     memcpy(mesh.indexBuffer->contents(), indices, 8 * sizeof(ushort));
+    mesh.indexType = MTL::IndexType::IndexTypeUInt16;
+    mesh.indexCount = 8;
 
     return mesh;
 }
 
-Mesh MeshFactory::buildSVG(MTL::Device* device, const char* svgFilePath) {
+// SvgMesh writes MeshVertex, the shaders read Vertex: both must stay byte compatible
+static_assert(sizeof(MeshVertex) == sizeof(Vertex), "MeshVertex must match Vertex");
+static_assert(offsetof(MeshVertex, color) == offsetof(Vertex, color), "MeshVertex must match Vertex");
+
+static MTL::Buffer* newBufferWithBytes(MTL::Device* device, std::span<const std::byte> bytes) {
+    MTL::Buffer* buffer = device->newBuffer(bytes.size(), MTL::ResourceStorageModeShared);
+    memcpy(buffer->contents(), bytes.data(), bytes.size());
+    return buffer;
+}
+
+// GPU buffers for mesh bytes; the index width follows from the vertex count. Packed meshes
+// upload PackedVertex instead of MeshVertex, plus their palette.
+static Mesh newMesh(MTL::Device* device, std::span<const std::byte> vertexBytes, std::span<const std::byte> indexBytes,
+                    std::span<const MeshRange> ranges, bool packed) {
     Mesh mesh;
-    std::vector<Vertex> vertices;
-    std::vector<ushort> indices;
-    
-    // Load SVG
-    NSVGimage* image = nsvgParseFromFile(svgFilePath, "px", 96);
-    if (!image) {
+    size_t vertexCount = vertexBytes.size() / sizeof(MeshVertex);
+    MeshIndexType indexType = SvgMesh::indexTypeFor(vertexCount);
+    PackedMesh packedMesh;
+    if (packed && PackedMesh::pack({ reinterpret_cast<const MeshVertex*>(vertexBytes.data()), vertexCount }, packedMesh)) {
+        mesh.vertexBuffer = newBufferWithBytes(device, asBytes(packedMesh.vertices));
+        mesh.paletteBuffer = newBufferWithBytes(device, asBytes(packedMesh.palette));
+        mesh.uniforms = packedMesh.uniforms;
+    } else {
+        mesh.vertexBuffer = newBufferWithBytes(device, vertexBytes);
+    }
+    mesh.indexBuffer = newBufferWithBytes(device, indexBytes);
+    mesh.indexType = indexType == MeshIndexType::UInt16 ? MTL::IndexType::IndexTypeUInt16 : MTL::IndexType::IndexTypeUInt32;
+    mesh.indexCount = indexBytes.size() / (size_t)indexType;
+    mesh.ranges.assign(ranges.begin(), ranges.end());
+    return mesh;
+}
+
+static Mesh buildSVGMesh(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options, bool packed) {
+    Mesh mesh;
+
+    // Load SVG: from the binary cache while it matches the file, else control points only,
+    // no NSVGimage is built
+    std::string cachePath = CurveCache::defaultPath(svgFilePath);
+    uint64_t sourceHash = 0;
+    bool hashed = CurveCache::hashFile(svgFilePath, sourceHash);
+    CurveCacheFile cache;
+    SvgSegments svg;
+    if (hashed && cache.open(cachePath.c_str(), sourceHash)) {
+        std::span<const std::byte> vertexBytes, indexBytes;
+        std::span<const MeshRange> ranges;
+        if (SvgMesh::findCached(cache, options, vertexBytes, indexBytes, ranges)) {
+            return newMesh(device, vertexBytes, indexBytes, ranges, packed);
+        }
+        svg = cache.toSegments();
+        cache.close();
+    } else {
+        svg = SvgSegments::fromFile(svgFilePath, "px", 96);
+    }
+    if (svg.size() == 0) {
         std::cerr << "Could not open SVG image." << std::endl;
         return mesh;
     }
 
-    ushort index = 0;
-    std::ofstream outFile("cubic_bezier_shapes.txt");
-    
     // Calculate bounds
-    float xMax = 0.0f, yMax = 0.0f, xMin = 0.0f, yMin = 0.0f;
-    for (NSVGshape* shape = image->shapes; shape != nullptr; shape = shape->next) {
-        xMin = shape->bounds[0];
-        yMin = shape->bounds[1];
-        xMax = shape->bounds[2];
-        yMax = shape->bounds[3];
+    Box2 bounds;
+    for (size_t i = 0; i < svg.size(); i++) {
+        bounds.expand(svg.get(i).p0);
+        bounds.expand(svg.get(i).p3);
     }
-    std::cout << xMin << " " << xMax << " " << yMin << " " << yMax << "\n";
+    std::cout << bounds.min.x << " " << bounds.max.x << " " << bounds.min.y << " " << bounds.max.y << "\n";
 
-    float widthOfImage = image->width;
-    float heightOfImage = image->height;
+    float widthOfImage = svg.width;
+    float heightOfImage = svg.height;
     float div = std::max(widthOfImage, heightOfImage);
     std::cout << widthOfImage << " " << heightOfImage << "\n";
 
-    for (NSVGshape* shape = image->shapes; shape != nullptr; shape = shape->next) {
-        for (NSVGpath* path = shape->paths; path != nullptr; path = path->next) {
-            for (int i = 0; i < path->npts - 1; i += 3) {
-                float* p = &path->pts[i * 2];
-                outFile << "Shape ID: " << (shape->id ? shape->id : "none") << ", Path Points:";
-                std::vector<Vertex> temp;
-                for (int j = 0; j < 4; ++j) {
-                    float xcoord = 2 * ((p[j * 2]) / div) - 1.0f;
-                    float ycoord = 1.0f - 2 * ((p[j * 2 + 1]) / div);
-                    temp.push_back({ { xcoord, ycoord }, { 1.0f, 0.0f, 0.0f } });
-                    outFile << "[" << xcoord << ", " << ycoord << "]";
-                    if (j < 3) outFile << ", ";
-                }
-                GenerateCubicBezierVertices(temp[0], temp[1], temp[2], temp[3], 100, vertices, indices, index);
-                //index++;
-                GenerateUnitNormalVertices(temp[0], temp[1], temp[2], temp[3], 100, vertices, indices, index);
-                outFile << std::endl;
-            }
+    std::ofstream outFile("cubic_bezier_shapes.txt");
+    for (size_t segmentIndex = 0; segmentIndex < svg.size(); segmentIndex++) {
+        CubicSegment segment = svg.get(segmentIndex);
+        outFile << "Shape ID: " << svg.shapeIds[segmentIndex] << ", Path Points:";
+        int j = 0;
+        for (const Point2* point : { &segment.p0, &segment.p1, &segment.p2, &segment.p3 }) {
+            outFile << "[" << 2 * (point->x / div) - 1.0f << ", " << 1.0f - 2 * (point->y / div) << "]";
+            if (j++ < 3) outFile << ", ";
         }
+        outFile << std::endl;
     }
-    
-    
-    
-    mesh.vertexBuffer = device->newBuffer(vertices.size() * sizeof(Vertex), MTL::ResourceStorageModeShared);
-    memcpy(mesh.vertexBuffer->contents(), vertices.data(), vertices.size() * sizeof(Vertex));
 
-    for (int i = 1; i < vertices.size(); i++) {
-        indices.push_back(i - 1);
-        indices.push_back(i);
-    }
+    SvgMesh built = SvgMesh::build(svg, options);
 
-    mesh.indexBuffer = device->newBuffer(indices.size() * sizeof(ushort), MTL::ResourceStorageModeShared);
-    memcpy(mesh.indexBuffer->contents(), indices.data(), indices.size() * sizeof(ushort));
+    mesh = newMesh(device, asBytes(built.vertices), built.indexBytes(), built.ranges, packed);
+
+    if (hashed) {
+        built.writeCache(cachePath.c_str(), sourceHash, svg);
+    }
 
     return mesh;
 }
 
+Mesh MeshFactory::buildSVG(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options) {
+    return buildSVGMesh(device, svgFilePath, options, false);
+}
+
+Mesh MeshFactory::buildSVGPacked(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options) {
+    return buildSVGMesh(device, svgFilePath, options, true);
+}
+
+Mesh MeshFactory::buildSVGStroke(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options) {
+    std::string cachePath = CurveCache::defaultPath(svgFilePath);
+    uint64_t sourceHash = 0;
+    bool hashed = CurveCache::hashFile(svgFilePath, sourceHash);
+    CurveCacheFile cache;
+    if (hashed && cache.open(cachePath.c_str(), sourceHash)) {
+        std::span<const std::byte> vertexBytes, indexBytes;
+        std::span<const MeshRange> ranges;
+        if (StrokeMesh::findCached(cache, options, vertexBytes, indexBytes, ranges)) {
+            return indexBytes.empty() ? Mesh() : newMesh(device, vertexBytes, indexBytes, ranges, false);
+        }
+    }
+
+    // Stroke styles only exist in the full parse
+    NSVGimage* image = nsvgParseFromFile(svgFilePath, "px", 96);
+    if (!image) {
+        std::cerr << "Could not open SVG image." << std::endl;
+        return Mesh();
+    }
+    SvgSegments svg = SvgSegments::fromImage(image);
+    StrokeMesh built = StrokeMesh::build(svg, SvgStyles::fromImage(image), options);
+    nsvgDelete(image);
+    if (hashed) {
+        cache.close();
+        CurveCache::update(cachePath.c_str(), sourceHash, svg, built.cacheBlobs());
+    }
+    if (built.indexCount() == 0) {
+        return Mesh();
+    }
+    return newMesh(device, asBytes(built.vertices), built.indexBytes(), built.ranges, false);
+}
+
+Mesh MeshFactory::buildSVGFill(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options) {
+    std::string cachePath = CurveCache::defaultPath(svgFilePath);
+    uint64_t sourceHash = 0;
+    bool hashed = CurveCache::hashFile(svgFilePath, sourceHash);
+    CurveCacheFile cache;
+    if (hashed && cache.open(cachePath.c_str(), sourceHash)) {
+        std::span<const std::byte> vertexBytes, indexBytes;
+        std::span<const MeshRange> ranges;
+        if (FillMesh::findCached(cache, options, vertexBytes, indexBytes, ranges)) {
+            return indexBytes.empty() ? Mesh() : newMesh(device, vertexBytes, indexBytes, ranges, false);
+        }
+    }
+
+    // Fill styles only exist in the full parse
+    NSVGimage* image = nsvgParseFromFile(svgFilePath, "px", 96);
+    if (!image) {
+        std::cerr << "Could not open SVG image." << std::endl;
+        return Mesh();
+    }
+    SvgSegments svg = SvgSegments::fromImage(image);
+    FillMesh built = FillMesh::build(svg, SvgStyles::fromImage(image), options);
+    nsvgDelete(image);
+    if (hashed) {
+        cache.close();
+        CurveCache::update(cachePath.c_str(), sourceHash, svg, built.cacheBlobs());
+    }
+    if (built.indexCount() == 0) {
+        return Mesh();
+    }
+    return newMesh(device, asBytes(built.vertices), built.indexBytes(), built.ranges, false);
+}
+
 //
 //
 //Mesh MeshFactory::buildNormal(MTL::Device* device, const char* svgFilePath) {
@@ -3,6 +3,9 @@
 #pragma once
 #include "../config.h"
 #include "nanosvg.h"
+#include "../geometry/bezier.h"
+#include "../geometry/packed_vertex.h"
+#include "../geometry/svg_mesh.h"
 #include <vector>
 struct svgVertex {
     float position[2];
@@ -13,16 +16,32 @@ struct svgVertex {
 //    MTL::Buffer* vertexBuffer, *indexBuffer;
 //};
 struct Mesh {
-    MTL::Buffer* vertexBuffer;
-    MTL::Buffer* indexBuffer;
-    
+    MTL::Buffer* vertexBuffer = nullptr;
+    MTL::Buffer* indexBuffer = nullptr;
+    MTL::IndexType indexType = MTL::IndexType::IndexTypeUInt16;
+    NS::UInteger indexCount = 0;
+    // SVG meshes only: where each path's strips sit in indexBuffer, for per-path draws and culling
+    std::vector<MeshRange> ranges;
+    // Packed meshes only: PackedVertex colors index this buffer of PackedColor
+    MTL::Buffer* paletteBuffer = nullptr;
+    PackedMeshUniforms uniforms;
 };
 
 namespace MeshFactory {
     MTL::Buffer* buildTriangle(MTL::Device* device);
     Mesh buildQuad(MTL::Device* device);
 //svg and line ka added
-    Mesh buildSVG(MTL::Device* device, const char* svgFilePath); // New method for SVG
+    Mesh buildSVG(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options = TessellationOptions()); // New method for SVG
+    // Same mesh with PackedVertex vertices (8 instead of 32 bytes); draw with kPackedVertexLayout
+    // and vertexMainPacked. Falls back to MeshVertex, without palette, past 65536 colors.
+    Mesh buildSVGPacked(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options = TessellationOptions());
+    // Stroked outlines (StrokeMesh): width, joins, caps and dashes from the shapes' stroke
+    // styles, as triangles in Vertex layout. Taken from the curve cache when svg_to_mesh
+    // --stroke baked them. No buffers if nothing is stroked.
+    Mesh buildSVGStroke(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options = TessellationOptions());
+    // Filled interiors (FillMesh) under each shape's fill rule, as triangles in Vertex layout.
+    // Taken from the curve cache when svg_to_mesh --fill baked them. No buffers if nothing is filled.
+    Mesh buildSVGFill(MTL::Device* device, const char* svgFilePath, const TessellationOptions& options = TessellationOptions());
     Mesh buildLine(MTL::Device* device); // New method for Line
     Mesh buildRectanglesAlongSVG(MTL::Device* device, const char* svgFilePath);
 //    Mesh buildNormal(MTL::Device* device, const char* svgFilePath);
@@ -9,21 +9,45 @@ Renderer::~Renderer() {
     triangleMesh->release();
     trianglePipeline->release();
     generalPipeline->release();
+    packedPipeline->release();
     svgMesh.vertexBuffer->release(); // Release SVG vertex buffer
     svgMesh.indexBuffer->release(); // Release SVG index buffer
+    if (svgMesh.paletteBuffer) {
+        svgMesh.paletteBuffer->release();
+    }
+    if (strokeMesh.vertexBuffer) {
+        strokeMesh.vertexBuffer->release();
+        strokeMesh.indexBuffer->release();
+    }
+    if (fillMesh.vertexBuffer) {
+        fillMesh.vertexBuffer->release();
+        fillMesh.indexBuffer->release();
+    }
     commandQueue->release();
     device->release();
 }
 void Renderer::buildMeshes() {
     triangleMesh = MeshFactory::buildTriangle(device);
-    svgMesh = MeshFactory::buildSVG(device, "//Users/rashmig/Desktop/filled_rect_around_shapes 2/square.svg");
+    svgMesh = MeshFactory::buildSVGPacked(device, "//Users/rashmig/Desktop/filled_rect_around_shapes 2/square.svg");
+    strokeMesh = MeshFactory::buildSVGStroke(device, "//Users/rashmig/Desktop/filled_rect_around_shapes 2/square.svg");
+    fillMesh = MeshFactory::buildSVGFill(device, "//Users/rashmig/Desktop/filled_rect_around_shapes 2/square.svg");
 //    normalMesh = MeshFactory::buildNormal(device, "/Users/rashmig/Desktop/line copy 2/horizontal-line-svgrepo-com.svg");
 }
 void Renderer::buildShaders() {
     trianglePipeline = buildShader("shaders/triangle.metal", "vertexMain", "fragmentMain");
     generalPipeline = buildShader("shaders/general_shader.metal", "vertexMainGeneral", "fragmentMainGeneral");
+    packedPipeline = buildShader("shaders/general_shader.metal", "vertexMainPacked", "fragmentMainGeneral", kPackedVertexLayout);
+}
+static MTL::VertexFormat vertexFormat(VertexAttributeFormat format) {
+    switch (format) {
+        case VertexAttributeFormat::Float2: return MTL::VertexFormat::VertexFormatFloat2;
+        case VertexAttributeFormat::Float3: return MTL::VertexFormat::VertexFormatFloat3;
+        case VertexAttributeFormat::UShort2Normalized: return MTL::VertexFormat::VertexFormatUShort2Normalized;
+        case VertexAttributeFormat::UShort: return MTL::VertexFormat::VertexFormatUShort;
+    }
+    return MTL::VertexFormat::VertexFormatInvalid;
 }
-MTL::RenderPipelineState* Renderer::buildShader(const char* filename, const char* vertName, const char* fragName) {
+MTL::RenderPipelineState* Renderer::buildShader(const char* filename, const char* vertName, const char* fragName, const VertexLayout& layout) {
     // Read the source code from the file.
     std::ifstream file(filename);
     std::stringstream reader;
@@ -53,15 +77,15 @@ MTL::RenderPipelineState* Renderer::buildShader(const char* filename, const char
     MTL::VertexDescriptor* vertexDescriptor = MTL::VertexDescriptor::alloc()->init();
     auto attributes = vertexDescriptor->attributes();
     auto positionDescriptor = attributes->object(0);
-    positionDescriptor->setFormat(MTL::VertexFormat::VertexFormatFloat2);
+    positionDescriptor->setFormat(vertexFormat(layout.position.format));
     positionDescriptor->setBufferIndex(0);
-    positionDescriptor->setOffset(0);
+    positionDescriptor->setOffset(layout.position.offset);
     auto colorDescriptor = attributes->object(1);
-    colorDescriptor->setFormat(MTL::VertexFormat::VertexFormatFloat3);
+    colorDescriptor->setFormat(vertexFormat(layout.color.format));
     colorDescriptor->setBufferIndex(0);
-    colorDescriptor->setOffset(4 * sizeof(float));
+    colorDescriptor->setOffset(layout.color.offset);
     auto layoutDescriptor = vertexDescriptor->layouts()->object(0);
-    layoutDescriptor->setStride(8 * sizeof(float));
+    layoutDescriptor->setStride(layout.stride);
 
     pipelineDescriptor->setVertexDescriptor(vertexDescriptor);
 
@@ -85,11 +109,29 @@ void Renderer::draw(MTK::View* view) {
     MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
     MTL::RenderPassDescriptor* renderPass = view->currentRenderPassDescriptor();
     MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(renderPass);
-    encoder->setRenderPipelineState(generalPipeline);
+    // Fills first, then stroked outlines, then the hairlines on top
+    if (fillMesh.indexCount > 0) {
+        encoder->setRenderPipelineState(generalPipeline);
+        encoder->setVertexBuffer(fillMesh.vertexBuffer, 0, 0);
+        encoder->drawIndexedPrimitives(MTL::PrimitiveType::PrimitiveTypeTriangle, fillMesh.indexCount, fillMesh.indexType, fillMesh.indexBuffer, 0);
+    }
+    if (strokeMesh.indexCount > 0) {
+        encoder->setRenderPipelineState(generalPipeline);
+        encoder->setVertexBuffer(strokeMesh.vertexBuffer, 0, 0);
+        encoder->drawIndexedPrimitives(MTL::PrimitiveType::PrimitiveTypeTriangle, strokeMesh.indexCount, strokeMesh.indexType, strokeMesh.indexBuffer, 0);
+    }
     // Draw SVG
+    if (svgMesh.paletteBuffer) {
+        encoder->setRenderPipelineState(packedPipeline);
+        encoder->setVertexBytes(&svgMesh.uniforms, sizeof(svgMesh.uniforms), 1);
+        encoder->setVertexBuffer(svgMesh.paletteBuffer, 0, 2);
+    } else {
+        encoder->setRenderPipelineState(generalPipeline);
+    }
     encoder->setVertexBuffer(svgMesh.vertexBuffer, 0, 0);
-    MTL::PrimitiveType primitiveType = MTL::PrimitiveType::PrimitiveTypeLine;
-    encoder->drawIndexedPrimitives(primitiveType, svgMesh.indexBuffer->length() / sizeof(ushort), MTL::IndexType::IndexTypeUInt16, svgMesh.indexBuffer, 0);
+    // One strip per path and per normal quad; Metal restarts strips at the all-ones index
+    MTL::PrimitiveType primitiveType = MTL::PrimitiveType::PrimitiveTypeLineStrip;
+    encoder->drawIndexedPrimitives(primitiveType, svgMesh.indexCount, svgMesh.indexType, svgMesh.indexBuffer, 0);
     encoder->endEncoding();
     commandBuffer->presentDrawable(view->currentDrawable());
     commandBuffer->commit();
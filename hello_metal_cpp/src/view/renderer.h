@@ -15,14 +15,16 @@ class Renderer
         void buildMeshes();
         void buildShaders();
     
-        MTL::RenderPipelineState* buildShader(const char* filename, const char* vertName, const char* fragName);
+        MTL::RenderPipelineState* buildShader(const char* filename, const char* vertName, const char* fragName, const VertexLayout& layout = kMeshVertexLayout);
         MTL::Device* device;
         MTL::CommandQueue* commandQueue;
         
-        MTL::RenderPipelineState* trianglePipeline, *generalPipeline;
+        MTL::RenderPipelineState* trianglePipeline, *generalPipeline, *packedPipeline;
         MTL::Buffer* triangleMesh;
 //        Mesh quadMesh;
         Mesh svgMesh;
+        Mesh strokeMesh;
+        Mesh fillMesh;
 //        Mesh lineMesh; // Add line mesh
     Mesh normalMesh;
 };